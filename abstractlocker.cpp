@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "abstractlocker.h"
 
 #include <QApplication>
+#include <QBackingStore>
 #include <QPainter>
 #include <QScreen>
 #include <QtDBus>
@@ -35,69 +36,130 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace ScreenLocker
 {
 BackgroundWindow::BackgroundWindow(AbstractLocker *lock)
-    : QRasterWindow()
+    : QWindow()
     , m_lock(lock)
 {
     setFlags(Qt::X11BypassWindowManagerHint | Qt::FramelessWindowHint);
     setProperty("org_kde_ksld_emergency", true);
+    prepareEmergencyText();
 }
 
 BackgroundWindow::~BackgroundWindow() = default;
 
-void BackgroundWindow::paintEvent(QPaintEvent *)
+void BackgroundWindow::prepareEmergencyText()
 {
-    QPainter p(this);
-    p.fillRect(0, 0, width(), height(), Qt::black);
-    if (m_greeterFailure) {
+    // shown till we know better
+    m_emergencyText = i18n(
+        "The screen locker is broken and unlocking is not possible anymore.\n"
+        "In order to unlock it either ConsoleKit or LoginD is needed, neither\n"
+        "of which could be found on your system.");
+
+    auto nameHasOwner = [](const QString &service) {
+        QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.DBus"),
+                                                              QStringLiteral("/org/freedesktop/DBus"),
+                                                              QStringLiteral("org.freedesktop.DBus"),
+                                                              QStringLiteral("NameHasOwner"));
+        message << service;
+        return QDBusPendingReply<bool>(QDBusConnection::systemBus().asyncCall(message));
+    };
+    const QDBusPendingReply<bool> consoleKit = nameHasOwner(QStringLiteral("org.freedesktop.ConsoleKit"));
+    const QDBusPendingReply<bool> logind = nameHasOwner(QStringLiteral("org.freedesktop.login1"));
+
+    auto finished = [this, consoleKit, logind](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        if (!consoleKit.isFinished() || !logind.isFinished()) {
+            return;
+        }
+        composeEmergencyText(!consoleKit.isError() && consoleKit.value(), !logind.isError() && logind.value());
+    };
+    connect(new QDBusPendingCallWatcher(consoleKit, this), &QDBusPendingCallWatcher::finished, this, finished);
+    connect(new QDBusPendingCallWatcher(logind, this), &QDBusPendingCallWatcher::finished, this, finished);
+}
+
+void BackgroundWindow::composeEmergencyText(bool haveConsoleKit, bool haveLogind)
+{
+    const int virtualTerminalId = qEnvironmentVariableIntValue("XDG_VTNR");
+    if (haveConsoleKit) {
         auto text = ki18n(
-            "The screen locker is broken and unlocking is not possible anymore.\n"
-            "In order to unlock it either ConsoleKit or LoginD is needed, neither\n"
-            "of which could be found on your system.");
-        auto text_ck = ki18n(
             "The screen locker is broken and unlocking is not possible anymore.\n"
             "In order to unlock switch to a virtual terminal (e.g. Ctrl+Alt+F%1),\n"
             "log in as root and execute the command:\n\n"
             "# ck-unlock-session <session-name>\n\n");
-        auto text_ld = ki18n(
+        m_emergencyText = text.subs(virtualTerminalId == 2 ? 1 : 2).toString();
+    } else if (haveLogind) {
+        auto text = ki18n(
             "The screen locker is broken and unlocking is not possible anymore.\n"
             "In order to unlock switch to a virtual terminal (e.g. Ctrl+Alt+F%1),\n"
             "log in and execute the command:\n\n"
             "loginctl unlock-session %2\n\n"
             "Then log out of the virtual session by pressing Ctrl+D, and switch\n"
             "back to the running session (Ctrl+Alt+F%3).");
+        text = text.subs(virtualTerminalId == 2 ? 1 : 2);
+        text = text.subs(QString::fromLocal8Bit(qgetenv("XDG_SESSION_ID")));
+        text = text.subs(virtualTerminalId);
+        m_emergencyText = text.toString();
+    } else {
+        return;
+    }
+    update();
+}
 
-        auto haveService = [](QString service) {
-            return QDBusConnection::systemBus().interface()->isServiceRegistered(service);
-        };
-        if (haveService(QStringLiteral("org.freedesktop.ConsoleKit"))) {
-            auto virtualTerminalId = qgetenv("XDG_VTNR").toInt();
-            text = text_ck.subs(virtualTerminalId == 2 ? 1 : 2);
-        } else if (haveService(QStringLiteral("org.freedesktop.login1"))) {
-            text = text_ld;
-            auto virtualTerminalId = qgetenv("XDG_VTNR").toInt();
-            text = text.subs(virtualTerminalId == 2 ? 1 : 2);
-            text = text.subs(QString::fromLocal8Bit(qgetenv("XDG_SESSION_ID")));
-            text = text.subs(virtualTerminalId);
-        }
-
-        p.setPen(Qt::white);
-        QFont f = p.font();
-        f.setBold(true);
-        f.setPointSize(24);
-        // for testing emergency mode, we need to disable antialias, as otherwise
-        // screen wouldn't be completely black and white.
-        if (qEnvironmentVariableIsSet("KSLD_TESTMODE")) {
-            f.setStyleStrategy(QFont::NoAntialias);
-        }
-        p.setFont(f);
-        const auto screens = QGuiApplication::screens();
-        for (auto s : screens) {
-            p.drawText(s->geometry(), Qt::AlignVCenter | Qt::AlignHCenter, text.toString());
-        }
+bool BackgroundWindow::event(QEvent *event)
+{
+    if (event->type() == QEvent::UpdateRequest) {
+        paintEmergency();
+        return true;
     }
+    return QWindow::event(event);
+}
+
+void BackgroundWindow::exposeEvent(QExposeEvent *)
+{
+    paintEmergency();
     m_lock->stayOnTop();
 }
 
+void BackgroundWindow::update()
+{
+    if (m_greeterFailure) {
+        requestUpdate();
+    }
+}
+
+void BackgroundWindow::paintEmergency()
+{
+    if (!m_greeterFailure || !isExposed()) {
+        return;
+    }
+    if (m_backingStore.isNull()) {
+        m_backingStore.reset(new QBackingStore(this));
+    }
+    const QRect rect(QPoint(0, 0), size());
+    if (m_backingStore->size() != size()) {
+        m_backingStore->resize(size());
+    }
+    m_backingStore->beginPaint(rect);
+    QPainter p(m_backingStore->paintDevice());
+    p.fillRect(rect, Qt::black);
+    p.setPen(Qt::white);
+    QFont f = p.font();
+    f.setBold(true);
+    f.setPointSize(24);
+    // for testing emergency mode, we need to disable antialias, as otherwise
+    // screen wouldn't be completely black and white.
+    if (qEnvironmentVariableIsSet("KSLD_TESTMODE")) {
+        f.setStyleStrategy(QFont::NoAntialias);
+    }
+    p.setFont(f);
+    const auto screens = QGuiApplication::screens();
+    for (auto s : screens) {
+        p.drawText(s->geometry(), Qt::AlignVCenter | Qt::AlignHCenter, m_emergencyText);
+    }
+    p.end();
+    m_backingStore->endPaint();
+    m_backingStore->flush(rect);
+}
+
 void BackgroundWindow::emergencyShow()
 {
     m_greeterFailure = true;
@@ -105,21 +167,42 @@ void BackgroundWindow::emergencyShow()
     show();
 }
 
+void BackgroundWindow::resetEmergency()
+{
+    m_greeterFailure = false;
+    m_backingStore.reset();
+}
+
 AbstractLocker::AbstractLocker(QObject *parent)
     : QObject(parent)
 {
-    if (qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
-        m_background.reset(new BackgroundWindow(this));
-    }
 }
 
 AbstractLocker::~AbstractLocker()
 {
 }
 
+bool AbstractLocker::ensureBackground()
+{
+    if (!m_background.isNull()) {
+        return true;
+    }
+    if (!qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
+        return false;
+    }
+    m_background.reset(new BackgroundWindow(this));
+    QRect geometry;
+    const auto screens = QGuiApplication::screens();
+    for (auto *screen : screens) {
+        geometry |= screen->geometry();
+    }
+    m_background->setGeometry(geometry);
+    return true;
+}
+
 void AbstractLocker::emergencyShow()
 {
-    if (m_background.isNull()) {
+    if (!ensureBackground()) {
         return;
     }
     m_background->emergencyShow();
@@ -130,4 +213,26 @@ void AbstractLocker::addAllowedWindow(quint32 windows)
     Q_UNUSED(windows);
 }
 
+bool AbstractLocker::showBackground()
+{
+    return false;
+}
+
+void AbstractLocker::notifyUserActivity()
+{
+    if (m_userActivityNotified) {
+        return;
+    }
+    // the first event is reported right away so that it ends the grace time,
+    // all further ones in the same event loop iteration are covered by it
+    m_userActivityNotified = true;
+    Q_EMIT userActivity();
+    QMetaObject::invokeMethod(this, &AbstractLocker::resetUserActivityNotified, Qt::QueuedConnection);
+}
+
+void AbstractLocker::resetUserActivityNotified()
+{
+    m_userActivityNotified = false;
+}
+
 }
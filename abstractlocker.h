@@ -27,15 +27,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define ABSTRACTLOCKER_H
 
 #include <QObject>
-#include <QRasterWindow>
+#include <QWindow>
 
 class GlobalAccel;
+class QBackingStore;
 
 namespace ScreenLocker
 {
 class AbstractLocker;
 
-class BackgroundWindow : public QRasterWindow
+/**
+ * The black background covering all screens.
+ *
+ * The window does not paint the black background itself, the locker has to give it a
+ * server side background. Client side pixels are only allocated for the emergency text.
+ **/
+class BackgroundWindow : public QWindow
 {
     Q_OBJECT
 public:
@@ -43,13 +50,33 @@ public:
     ~BackgroundWindow() override;
 
     void emergencyShow();
+    /**
+     * Goes back to the plain black background after emergencyShow and frees the pixels
+     * of the emergency text.
+     **/
+    void resetEmergency();
+    /**
+     * Schedules painting the emergency text, does nothing for the plain black background.
+     **/
+    void update();
 
 protected:
-    void paintEvent(QPaintEvent *) override;
+    bool event(QEvent *event) override;
+    void exposeEvent(QExposeEvent *event) override;
 
 private:
+    /**
+     * Looks up asynchronously how the session can be unlocked from a virtual terminal, so
+     * that painting the emergency text does not block on D-Bus.
+     **/
+    void prepareEmergencyText();
+    void composeEmergencyText(bool haveConsoleKit, bool haveLogind);
+    void paintEmergency();
+
     AbstractLocker *m_lock;
     bool m_greeterFailure = false;
+    QString m_emergencyText;
+    QScopedPointer<QBackingStore> m_backingStore;
 };
 
 class AbstractLocker : public QObject
@@ -63,6 +90,12 @@ public:
     virtual void hideLockWindow() = 0;
 
     virtual void addAllowedWindow(quint32 window);
+    /**
+     * Covers all screens with the black background right away instead of waiting for the
+     * first greeter window. lockWindowShown is emitted once the background is on screen.
+     * Does nothing and returns @c false if the locker cannot provide that guarantee.
+     **/
+    virtual bool showBackground();
 
     void setGlobalAccel(GlobalAccel *ga)
     {
@@ -71,12 +104,22 @@ public:
 
     void emergencyShow();
 
+    /**
+     * Emits userActivity, at most once per event loop iteration.
+     **/
+    void notifyUserActivity();
+
 Q_SIGNALS:
     void userActivity();
     void lockWindowShown();
 
 protected:
     virtual void stayOnTop() = 0;
+    /**
+     * Creates the background window covering all screens if there is none yet.
+     * Returns @c false if there cannot be one, that is without a QGuiApplication.
+     **/
+    bool ensureBackground();
 
     GlobalAccel *globalAccel()
     {
@@ -85,7 +128,10 @@ protected:
     QScopedPointer<BackgroundWindow> m_background;
 
 private:
+    void resetUserActivityNotified();
+
     GlobalAccel *m_globalAccel = nullptr;
+    bool m_userActivityNotified = false;
 
     friend class BackgroundWindow;
 };
@@ -0,0 +1,169 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// own
+#include "../globalshortcutindex.h"
+// Qt
+#include <QtTest>
+
+class GlobalShortcutIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFind();
+    void testFirstWins();
+    void testMultipleKeyPresses();
+    void benchmarkLookup_data();
+    void benchmarkLookup();
+};
+
+void GlobalShortcutIndexTest::testFind()
+{
+    const int volumeUp = int(Qt::Key_VolumeUp);
+    const int zoomIn = int(Qt::MetaModifier) | int(Qt::Key_Plus);
+    GlobalShortcutIndex index;
+    QVERIFY(index.isEmpty());
+    index.add(QStringLiteral("/component/kmix"), QStringLiteral("increase_volume"), {QKeySequence(volumeUp)});
+    index.add(QStringLiteral("/component/kwin"), QStringLiteral("view_zoom_in"), {QKeySequence(zoomIn), QKeySequence(int(Qt::MetaModifier) | int(Qt::Key_Equal))});
+    QCOMPARE(index.size(), 3);
+
+    const GlobalShortcutIndex::Shortcut *shortcut = index.find(volumeUp);
+    QVERIFY(shortcut);
+    QCOMPARE(shortcut->componentPath, QStringLiteral("/component/kmix"));
+    QCOMPARE(shortcut->uniqueName, QStringLiteral("increase_volume"));
+
+    shortcut = index.find(int(Qt::MetaModifier) | int(Qt::Key_Equal));
+    QVERIFY(shortcut);
+    QCOMPARE(shortcut->uniqueName, QStringLiteral("view_zoom_in"));
+
+    // the modifiers are part of the key
+    QVERIFY(!index.find(int(Qt::Key_Plus)));
+    QVERIFY(!index.find(int(Qt::ShiftModifier) | volumeUp));
+
+    index.clear();
+    QVERIFY(index.isEmpty());
+    QVERIFY(!index.find(volumeUp));
+}
+
+void GlobalShortcutIndexTest::testFirstWins()
+{
+    const int mute = int(Qt::Key_VolumeMute);
+    GlobalShortcutIndex index;
+    index.add(QStringLiteral("/component/kmix"), QStringLiteral("mute"), {QKeySequence(mute)});
+    index.add(QStringLiteral("/component/mediacontrol"), QStringLiteral("stopmedia"), {QKeySequence(mute)});
+    QCOMPARE(index.size(), 1);
+    const GlobalShortcutIndex::Shortcut *shortcut = index.find(mute);
+    QVERIFY(shortcut);
+    QCOMPARE(shortcut->componentPath, QStringLiteral("/component/kmix"));
+    QCOMPARE(shortcut->uniqueName, QStringLiteral("mute"));
+}
+
+void GlobalShortcutIndexTest::testMultipleKeyPresses()
+{
+    const int first = int(Qt::ControlModifier) | int(Qt::Key_K);
+    const int second = int(Qt::ControlModifier) | int(Qt::Key_L);
+    GlobalShortcutIndex index;
+    index.add(QStringLiteral("/component/kwin"), QStringLiteral("chord"), {QKeySequence(first, second), QKeySequence()});
+    QVERIFY(index.isEmpty());
+    QVERIFY(!index.find(first));
+}
+
+void GlobalShortcutIndexTest::benchmarkLookup_data()
+{
+    QTest::addColumn<bool>("indexed");
+
+    QTest::newRow("scan") << false;
+    QTest::newRow("index") << true;
+}
+
+void GlobalShortcutIndexTest::benchmarkLookup()
+{
+    // a large set of shortcuts: 50 components with 40 shortcuts of two keys each,
+    // looked up by key presses of which most do not trigger any shortcut
+    struct Info {
+        QString uniqueName;
+        QList<QKeySequence> keys;
+    };
+    const int modifiers[] = {int(Qt::MetaModifier),
+                             int(Qt::ControlModifier) | int(Qt::AltModifier),
+                             int(Qt::MetaModifier) | int(Qt::ShiftModifier),
+                             int(Qt::ControlModifier) | int(Qt::MetaModifier)};
+    QMap<QString, QList<Info>> shortcuts;
+    GlobalShortcutIndex index;
+    int key = 0;
+    auto nextKey = [&modifiers, &key]() {
+        const int combined = modifiers[key % 4] | (int(Qt::Key_F1) + key / 4);
+        ++key;
+        return combined;
+    };
+    for (int component = 0; component < 50; ++component) {
+        const QString path = QStringLiteral("/component/test%1").arg(component);
+        QList<Info> infos;
+        for (int shortcut = 0; shortcut < 40; ++shortcut) {
+            Info info{QStringLiteral("shortcut%1").arg(shortcut), {QKeySequence(nextKey()), QKeySequence(nextKey())}};
+            index.add(path, info.uniqueName, info.keys);
+            infos << info;
+        }
+        shortcuts.insert(path, infos);
+    }
+    QCOMPARE(index.size(), 4000);
+
+    QVector<int> presses;
+    QRandomGenerator random(42);
+    for (int i = 0; i < 1000; ++i) {
+        presses << (modifiers[random.bounded(4)] | (int(Qt::Key_F1) + random.bounded(2000)));
+    }
+
+    QFETCH(bool, indexed);
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        for (int press : qAsConst(presses)) {
+            if (indexed) {
+                if (index.find(press)) {
+                    ++found;
+                }
+                continue;
+            }
+            // what GlobalAccel did before having the index
+            const QKeySequence seq(press);
+            bool match = false;
+            for (auto it = shortcuts.constBegin(); it != shortcuts.constEnd() && !match; ++it) {
+                for (const Info &info : it.value()) {
+                    if (info.keys.contains(seq)) {
+                        match = true;
+                        break;
+                    }
+                }
+            }
+            if (match) {
+                ++found;
+            }
+        }
+    }
+    // both find the same shortcuts
+    int expected = 0;
+    for (int press : qAsConst(presses)) {
+        if ((press & ~int(Qt::KeyboardModifierMask)) - int(Qt::Key_F1) < 1000) {
+            ++expected;
+        }
+    }
+    QCOMPARE(found, expected);
+}
+
+QTEST_GUILESS_MAIN(GlobalShortcutIndexTest)
+#include "globalshortcutindextest.moc"
@@ -0,0 +1,144 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// own
+#include "../inhibitregistry.h"
+// Qt
+#include <QtTest>
+// other
+#include <limits>
+
+using ScreenLocker::InhibitRegistry;
+
+class InhibitRegistryTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testAddRemove();
+    void testForwardedCookie();
+    void testRemoveSender();
+    void testCookieWrapAround();
+    void benchmarkManyInhibitors();
+};
+
+void InhibitRegistryTest::testAddRemove()
+{
+    InhibitRegistry registry(100);
+    QVERIFY(registry.isEmpty());
+    const uint first = registry.add(QStringLiteral(":1.1"));
+    const uint second = registry.add(QStringLiteral(":1.1"));
+    const uint third = registry.add(QStringLiteral(":1.2"));
+    QCOMPARE(first, 100u);
+    QCOMPARE(second, 101u);
+    QCOMPARE(third, 102u);
+    QCOMPARE(registry.count(), 3);
+    QCOMPARE(registry.count(QStringLiteral(":1.1")), 2);
+
+    InhibitRegistry::Entry removed;
+    QVERIFY(registry.remove(second, &removed));
+    QCOMPARE(removed.sender, QStringLiteral(":1.1"));
+    QVERIFY(!registry.remove(second));
+    QVERIFY(!registry.contains(second));
+    QVERIFY(registry.hasSender(QStringLiteral(":1.1")));
+
+    QVERIFY(registry.remove(first));
+    QVERIFY(!registry.hasSender(QStringLiteral(":1.1")));
+    QCOMPARE(registry.count(QStringLiteral(":1.1")), 0);
+    QVERIFY(registry.remove(third));
+    QVERIFY(registry.isEmpty());
+}
+
+void InhibitRegistryTest::testForwardedCookie()
+{
+    InhibitRegistry registry;
+    const uint cookie = registry.add(QStringLiteral(":1.1"));
+    QVERIFY(registry.setForwardedCookie(cookie, 42));
+
+    InhibitRegistry::Entry removed;
+    QVERIFY(registry.remove(cookie, &removed));
+    QCOMPARE(removed.forwardedCookie, 42u);
+    // the reply for an already released cookie
+    QVERIFY(!registry.setForwardedCookie(cookie, 43));
+}
+
+void InhibitRegistryTest::testRemoveSender()
+{
+    InhibitRegistry registry;
+    for (int i = 0; i < 5; ++i) {
+        const uint cookie = registry.add(QStringLiteral(":1.1"));
+        registry.setForwardedCookie(cookie, i + 1);
+    }
+    const uint other = registry.add(QStringLiteral(":1.2"));
+
+    const QVector<InhibitRegistry::Entry> removed = registry.removeSender(QStringLiteral(":1.1"));
+    QCOMPARE(removed.size(), 5);
+    QSet<uint> forwarded;
+    for (const auto &entry : removed) {
+        QCOMPARE(entry.sender, QStringLiteral(":1.1"));
+        forwarded << entry.forwardedCookie;
+    }
+    QCOMPARE(forwarded, QSet<uint>({1, 2, 3, 4, 5}));
+    QCOMPARE(registry.count(), 1);
+    QVERIFY(registry.contains(other));
+    QVERIFY(!registry.hasSender(QStringLiteral(":1.1")));
+    QVERIFY(registry.removeSender(QStringLiteral(":1.1")).isEmpty());
+}
+
+void InhibitRegistryTest::testCookieWrapAround()
+{
+    InhibitRegistry registry(std::numeric_limits<uint>::max());
+    const uint last = registry.add(QStringLiteral(":1.1"));
+    QCOMPARE(last, std::numeric_limits<uint>::max());
+    QCOMPARE(registry.add(QStringLiteral(":1.1")), 0u);
+}
+
+void InhibitRegistryTest::benchmarkManyInhibitors()
+{
+    // browsers with many media elements hold hundreds of inhibitions each,
+    // half of them get released one by one, the rest when the browsers quit
+    const int senders = 20;
+    const int perSender = 500;
+    QStringList names;
+    for (int i = 0; i < senders; ++i) {
+        names << QStringLiteral(":1.%1").arg(i + 100);
+    }
+
+    QBENCHMARK {
+        InhibitRegistry registry;
+        QVector<uint> cookies;
+        cookies.reserve(senders * perSender);
+        for (int i = 0; i < perSender; ++i) {
+            for (const QString &name : qAsConst(names)) {
+                const uint cookie = registry.add(name);
+                registry.setForwardedCookie(cookie, cookie + 1);
+                cookies << cookie;
+            }
+        }
+        for (int i = 0; i < cookies.size(); i += 2) {
+            registry.remove(cookies.at(i));
+        }
+        int released = 0;
+        for (const QString &name : qAsConst(names)) {
+            released += registry.removeSender(name).size();
+        }
+        QCOMPARE(released, senders * perSender / 2);
+        QVERIFY(registry.isEmpty());
+    }
+}
+
+QTEST_GUILESS_MAIN(InhibitRegistryTest)
+#include "inhibitregistrytest.moc"
@@ -0,0 +1,178 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// own
+#include "../ksldapp.h"
+// Qt
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtTest>
+// other
+#include <algorithm>
+#include <unistd.h>
+
+/**
+ * Drives KSldApp through many lock and unlock cycles with a stub greeter and reports the
+ * latency of the individual steps as JSON. Meant to be run under Xvfb.
+ *
+ * The number of cycles is read from KSLD_BENCHMARK_CYCLES (default 1000), the report gets
+ * written to stdout and, if set, to the file named by KSLD_BENCHMARK_OUTPUT.
+ **/
+class KSldBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkLockCycle();
+
+private:
+    static QJsonObject percentiles(QVector<qint64> samples);
+    static qint64 residentSetSize();
+};
+
+void KSldBenchmark::initTestCase()
+{
+    QCoreApplication::setAttribute(Qt::AA_ForceRasterWidgets);
+    // change to the build bin dir
+    QDir::setCurrent(QCoreApplication::applicationDirPath());
+}
+
+QJsonObject KSldBenchmark::percentiles(QVector<qint64> samples)
+{
+    QJsonObject result;
+    if (samples.isEmpty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](int percent) {
+        // nearest-rank method, reported in milliseconds
+        const int rank = qMax(1, (percent * samples.size() + 99) / 100);
+        return samples.at(rank - 1) / 1000000.0;
+    };
+    result.insert(QStringLiteral("p50"), percentile(50));
+    result.insert(QStringLiteral("p99"), percentile(99));
+    result.insert(QStringLiteral("max"), samples.last() / 1000000.0);
+    return result;
+}
+
+qint64 KSldBenchmark::residentSetSize()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    // second field are the resident pages
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+void KSldBenchmark::benchmarkLockCycle()
+{
+    bool ok = false;
+    int cycles = qEnvironmentVariableIntValue("KSLD_BENCHMARK_CYCLES", &ok);
+    if (!ok || cycles <= 0) {
+        cycles = 1000;
+    }
+
+    ScreenLocker::KSldApp ksld(this);
+    ksld.initialize();
+    ksld.setGreeterPath(QDir::current().absoluteFilePath(QStringLiteral("stubGreeter")));
+    ksld.setGraceTime(0);
+
+    QSignalSpy lockedSpy(&ksld, &ScreenLocker::KSldApp::locked);
+    QVERIFY(lockedSpy.isValid());
+    QSignalSpy unlockedSpy(&ksld, &ScreenLocker::KSldApp::unlocked);
+    QVERIFY(unlockedSpy.isValid());
+
+    QObject *logind = nullptr;
+    const auto children = ksld.children();
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        if (qstrcmp((*it)->metaObject()->className(), "LogindIntegration") == 0) {
+            logind = *it;
+            break;
+        }
+    }
+    QVERIFY(logind);
+
+    QElapsedTimer lockTimer;
+
+    QVector<qint64> grabSamples, doUnlockSamples, lockSamples, spawnSamples, readySamples, unlockSamples;
+    const qint64 rssStart = residentSetSize();
+
+    for (int i = 0; i < cycles; ++i) {
+        // the grab on its own, without the lock window and the greeter
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(ksld.establishGrab());
+        grabSamples << timer.nsecsElapsed();
+        timer.restart();
+        ksld.doUnlock();
+        doUnlockSamples << timer.nsecsElapsed();
+        unlockedSpy.clear();
+
+        // a complete cycle till the greeter reported being ready and back
+        lockTimer.start();
+        ksld.lock(ScreenLocker::EstablishLock::Immediate);
+        lockSamples << lockTimer.nsecsElapsed();
+        QVERIFY(lockedSpy.count() || lockedSpy.wait(10000));
+        readySamples << lockTimer.nsecsElapsed();
+        // the greeter gets started inside of lock(), KSldApp tracks when exactly
+        const QVariantMap greeterStarted = ksld.lockLatency().value(QStringLiteral("greeterStarted")).toMap();
+        if (!greeterStarted.isEmpty()) {
+            spawnSamples << qint64(greeterStarted.value(QStringLiteral("last")).toDouble() * 1000000);
+        }
+        lockedSpy.clear();
+
+        timer.restart();
+        QMetaObject::invokeMethod(logind, "requestUnlock");
+        QVERIFY(unlockedSpy.count() || unlockedSpy.wait(10000));
+        unlockSamples << timer.nsecsElapsed();
+        unlockedSpy.clear();
+    }
+
+    const qint64 rssEnd = residentSetSize();
+
+    QJsonObject report;
+    report.insert(QStringLiteral("cycles"), cycles);
+    report.insert(QStringLiteral("establishGrab"), percentiles(grabSamples));
+    report.insert(QStringLiteral("doUnlock"), percentiles(doUnlockSamples));
+    report.insert(QStringLiteral("lock"), percentiles(lockSamples));
+    report.insert(QStringLiteral("greeterSpawn"), percentiles(spawnSamples));
+    report.insert(QStringLiteral("lockToReady"), percentiles(readySamples));
+    report.insert(QStringLiteral("unlock"), percentiles(unlockSamples));
+    report.insert(QStringLiteral("rssStartKiB"), rssStart);
+    report.insert(QStringLiteral("rssEndKiB"), rssEnd);
+    report.insert(QStringLiteral("rssDriftKiB"), rssEnd - rssStart);
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    fprintf(stdout, "%s", json.constData());
+    fflush(stdout);
+
+    const QString outputFile = qEnvironmentVariable("KSLD_BENCHMARK_OUTPUT");
+    if (!outputFile.isEmpty()) {
+        QFile file(outputFile);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(json);
+    }
+}
+
+QTEST_MAIN(KSldBenchmark)
+#include "ksldbenchmark.moc"
@@ -19,9 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 // own
 #include "../ksldapp.h"
+#include "../greeterprocess.h"
 // KDE Frameworks
 #include <KIdleTime>
 // Qt
+#include <QDBusConnection>
+#include <QDBusPendingReply>
 #include <QProcess>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <private/qtx11extras_p.h>
@@ -41,6 +44,8 @@ private Q_SLOTS:
     void testEstablishGrab();
     void testActivateOnTimeout();
     void testGraceTimeUnlocking();
+    void testStandbyGreeter();
+    void testThrottle();
 };
 
 void KSldTest::initTestCase()
@@ -186,5 +191,170 @@ void KSldTest::testGraceTimeUnlocking()
     QVERIFY(unlockedSpy.wait());
 }
 
+void KSldTest::testStandbyGreeter()
+{
+    // this test compares the time till the screen is locked with a cold started greeter
+    // and with a greeter which got prepared in standby
+    ScreenLocker::KSldApp ksld(this);
+    ksld.initialize();
+
+    qRegisterMetaType<QProcess::ExitStatus>();
+    QObject *greeter = ksld.m_lockProcess;
+    QSignalSpy startedSpy(greeter, SIGNAL(started()));
+    QVERIFY(startedSpy.isValid());
+    QSignalSpy finishedSpy(greeter, SIGNAL(finished(int,QProcess::ExitStatus)));
+    QVERIFY(finishedSpy.isValid());
+    QSignalSpy lockedSpy(&ksld, &ScreenLocker::KSldApp::locked);
+    QVERIFY(lockedSpy.isValid());
+    QSignalSpy unlockedSpy(&ksld, &ScreenLocker::KSldApp::unlocked);
+    QVERIFY(unlockedSpy.isValid());
+
+    // the configuration might have started a standby greeter already
+    const bool standbyRunning = ksld.m_greeterInStandby;
+    ksld.setGreeterStandbyEnabled(false);
+    if (standbyRunning) {
+        QVERIFY(finishedSpy.wait());
+    }
+    QVERIFY(!ksld.m_greeterInStandby);
+    QVERIFY(!ksld.m_greeterStandbyStopping);
+
+    auto requestUnlock = [&ksld]() {
+        const auto children = ksld.children();
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            if (qstrcmp((*it)->metaObject()->className(), "LogindIntegration") != 0) {
+                continue;
+            }
+            QMetaObject::invokeMethod(*it, "requestUnlock");
+            break;
+        }
+    };
+
+    // lock like the idle timeout does, so that the grace time applies
+    const int graceTime = 60000;
+    auto lockInGraceTime = [&ksld, graceTime]() {
+        ksld.m_lockGrace = graceTime;
+        ksld.m_inGraceTime = true;
+        ksld.lock(ScreenLocker::EstablishLock::Delayed);
+    };
+    // the grace time has to be armed the same way for both kinds of greeters
+    auto verifyGraceTime = [&ksld, graceTime]() {
+        QVERIFY(ksld.isGraceTime());
+        QVERIFY(ksld.m_graceTimer->isActive());
+        QCOMPARE(ksld.m_graceTimer->interval(), graceTime);
+        ksld.endGraceTime();
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    lockInGraceTime();
+    QTRY_COMPARE(startedSpy.count(), 1);
+    QVERIFY(lockedSpy.wait(30000));
+    const qint64 coldLockTime = timer.elapsed();
+    QCOMPARE(ksld.lockState(), ScreenLocker::KSldApp::Locked);
+    verifyGraceTime();
+
+    finishedSpy.clear();
+    requestUnlock();
+    QVERIFY(unlockedSpy.wait());
+    if (finishedSpy.isEmpty()) {
+        QVERIFY(finishedSpy.wait());
+    }
+
+    // now let the greeter prepare itself in the background
+    startedSpy.clear();
+    ksld.setGreeterStandbyEnabled(true);
+    QTRY_COMPARE(startedSpy.count(), 1);
+    QVERIFY(ksld.m_greeterInStandby);
+
+    // locking activates the prepared greeter instead of starting another one
+    startedSpy.clear();
+    timer.restart();
+    lockInGraceTime();
+    QVERIFY(!ksld.m_greeterInStandby);
+    QVERIFY(lockedSpy.wait(30000));
+    const qint64 standbyLockTime = timer.elapsed();
+    QCOMPARE(ksld.lockState(), ScreenLocker::KSldApp::Locked);
+    QVERIFY(startedSpy.isEmpty());
+    verifyGraceTime();
+
+    // includes the part of the preparation which was still running when locking
+    qDebug() << "Time till locked with cold greeter:" << coldLockTime << "ms, with standby greeter:" << standbyLockTime << "ms";
+
+    // after unlocking the next greeter gets prepared once the old one is gone
+    finishedSpy.clear();
+    requestUnlock();
+    QVERIFY(unlockedSpy.wait());
+    QVERIFY(startedSpy.wait());
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(ksld.m_greeterInStandby);
+
+    // disabling standby stops the prepared greeter without starting a new one
+    finishedSpy.clear();
+    startedSpy.clear();
+    ksld.setGreeterStandbyEnabled(false);
+    QVERIFY(finishedSpy.wait());
+    QVERIFY(!ksld.m_greeterInStandby);
+    QVERIFY(!ksld.m_greeterStandbyStopping);
+    QVERIFY(startedSpy.isEmpty());
+
+    // the stopped standby greeter must not be used, locking starts a new one
+    ksld.lock(ScreenLocker::EstablishLock::Immediate);
+    QTRY_COMPARE(startedSpy.count(), 1);
+    QVERIFY(lockedSpy.wait(30000));
+    QCOMPARE(ksld.lockState(), ScreenLocker::KSldApp::Locked);
+
+    requestUnlock();
+    QVERIFY(unlockedSpy.wait());
+}
+
+static QDBusMessage screenSaverCall(const QString &method)
+{
+    return QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.ScreenSaver"),
+                                          QStringLiteral("/org/freedesktop/ScreenSaver"),
+                                          QStringLiteral("org.freedesktop.ScreenSaver"),
+                                          method);
+}
+
+void KSldTest::testThrottle()
+{
+    ScreenLocker::KSldApp ksld;
+    ksld.initialize();
+    QVERIFY(!ksld.isThrottled());
+
+    // a separate connection acts as the client, disconnecting it makes its name go away
+    const QString clientName = QStringLiteral("throttleClient");
+    QDBusConnection client = QDBusConnection::connectToBus(QDBusConnection::SessionBus, clientName);
+    QVERIFY(client.isConnected());
+
+    QDBusMessage throttle = screenSaverCall(QStringLiteral("Throttle"));
+    throttle << QStringLiteral("ksldTest") << QStringLiteral("testing");
+    QDBusPendingReply<uint> first = client.asyncCall(throttle);
+    QDBusPendingReply<uint> second = client.asyncCall(throttle);
+    QTRY_VERIFY(second.isFinished());
+    QVERIFY(first.isValid());
+    QVERIFY(second.isValid());
+    QVERIFY(ksld.isThrottled());
+
+    // the greeter stays throttled till the last throttle is gone
+    QDBusMessage unThrottle = screenSaverCall(QStringLiteral("UnThrottle"));
+    unThrottle << first.value();
+    QDBusPendingReply<> reply = client.asyncCall(unThrottle);
+    QTRY_VERIFY(reply.isFinished());
+    QVERIFY(ksld.isThrottled());
+
+    unThrottle.setArguments({second.value()});
+    reply = client.asyncCall(unThrottle);
+    QTRY_VERIFY(reply.isFinished());
+    QVERIFY(!ksld.isThrottled());
+
+    // a client going away releases its throttles
+    QDBusPendingReply<uint> third = client.asyncCall(throttle);
+    QTRY_VERIFY(third.isFinished());
+    QVERIFY(third.isValid());
+    QVERIFY(ksld.isThrottled());
+    QDBusConnection::disconnectFromBus(clientName);
+    QTRY_VERIFY(!ksld.isThrottled());
+}
+
 QTEST_MAIN(KSldTest)
 #include "ksldtest.moc"
@@ -0,0 +1,138 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include <QCoreApplication>
+#include <QStringList>
+// Wayland
+#include <wayland-client.h>
+#include <wayland-ksld-client-protocol.h>
+// xcb
+#include <xcb/xcb.h>
+// other
+#include <time.h>
+
+static org_kde_ksld *s_ksld = nullptr;
+
+static void registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    Q_UNUSED(data)
+    if (qstrcmp(interface, org_kde_ksld_interface.name) == 0) {
+        s_ksld = reinterpret_cast<org_kde_ksld *>(wl_registry_bind(registry, name, &org_kde_ksld_interface, qMin(version, 5u)));
+    }
+}
+
+static void registryGlobalRemove(void *data, wl_registry *registry, uint32_t name)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(registry)
+    Q_UNUSED(name)
+}
+
+static const wl_registry_listener s_registryListener = {
+    .global = registryGlobal,
+    .global_remove = registryGlobalRemove,
+};
+
+/**
+ * A greeter replacement doing the bare minimum ksld expects from a greeter: it maps
+ * one window, announces it and reports being ready. It never unlocks on its own and
+ * gets terminated by ksld.
+ * It is used from ksldbenchmark to measure ksld without the costs of the real greeter.
+ **/
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+    const int fdIndex = arguments.indexOf(QStringLiteral("--ksldfd"));
+    if (fdIndex == -1 || fdIndex + 1 >= arguments.size()) {
+        return 1;
+    }
+    bool ok = false;
+    const int fd = arguments.at(fdIndex + 1).toInt(&ok);
+    if (!ok) {
+        return 1;
+    }
+
+    // connect to xcb and map a window covering the screen
+    int screenNumber = 0;
+    xcb_connection_t *c = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(c)) {
+        return 1;
+    }
+    xcb_screen_t *screen = nullptr;
+    for (auto it = xcb_setup_roots_iterator(xcb_get_setup(c)); it.rem; --screenNumber, xcb_screen_next(&it)) {
+        if (screenNumber == 0) {
+            screen = it.data;
+            break;
+        }
+    }
+    if (!screen) {
+        return 1;
+    }
+    const xcb_window_t window = xcb_generate_id(c);
+    const uint32_t values[] = {screen->black_pixel, true};
+    xcb_create_window(c,
+                      XCB_COPY_FROM_PARENT,
+                      window,
+                      screen->root,
+                      0,
+                      0,
+                      screen->width_in_pixels,
+                      screen->height_in_pixels,
+                      0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      XCB_COPY_FROM_PARENT,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT,
+                      values);
+
+    // connect to ksld
+    wl_display *display = wl_display_connect_to_fd(fd);
+    if (!display) {
+        return 1;
+    }
+    wl_registry *registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &s_registryListener, nullptr);
+    wl_display_roundtrip(display);
+    if (!s_ksld) {
+        return 1;
+    }
+
+    org_kde_ksld_x11window(s_ksld, window);
+    wl_display_flush(display);
+    xcb_map_window(c, window);
+    xcb_flush(c);
+
+    // the map request is processed once a round trip to the X server finished
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), nullptr));
+
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    wl_array timestamps;
+    wl_array_init(&timestamps);
+    *static_cast<uint64_t *>(wl_array_add(&timestamps, sizeof(uint64_t))) = uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    org_kde_ksld_ready(s_ksld, &timestamps);
+    wl_array_release(&timestamps);
+    wl_display_flush(display);
+
+    const int exitCode = app.exec();
+
+    wl_display_disconnect(display);
+    xcb_disconnect(c);
+
+    return exitCode;
+}
@@ -30,17 +30,35 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QtTest>
 // xcb
 #include <xcb/xcb.h>
+// other
+#include <atomic>
+#include <dlfcn.h>
 
 template<typename T>
 using ScopedCPointer = QScopedPointer<T, QScopedPointerPodDeleter>;
 
+// every xcb_*_reply call waits through this, each of them is a round trip to the X server
+static std::atomic<int> s_roundTrips{0};
+
+extern "C" void *xcb_wait_for_reply(xcb_connection_t *c, unsigned int request, xcb_generic_error_t **e)
+{
+    using WaitForReply = void *(*)(xcb_connection_t *, unsigned int, xcb_generic_error_t **);
+    static const auto waitForReply = reinterpret_cast<WaitForReply>(dlsym(RTLD_NEXT, "xcb_wait_for_reply"));
+    ++s_roundTrips;
+    return waitForReply(c, request, e);
+}
+
 class LockWindowTest : public QObject
 {
     Q_OBJECT
 private Q_SLOTS:
     void initTestCase();
+    void testBlankScreen_data();
     void testBlankScreen();
     void testEmergencyShow();
+    void benchmarkMotionForwarding();
+    void benchmarkInitialize_data();
+    void benchmarkInitialize();
 };
 
 xcb_screen_t *defaultScreen()
@@ -102,6 +120,14 @@ void LockWindowTest::initTestCase()
     QCoreApplication::setAttribute(Qt::AA_ForceRasterWidgets);
 }
 
+void LockWindowTest::testBlankScreen_data()
+{
+    QTest::addColumn<bool>("compositeOverlay");
+
+    QTest::newRow("restacking") << false;
+    QTest::newRow("composite overlay") << true;
+}
+
 void LockWindowTest::testBlankScreen()
 {
     // create and show a dummy window to ensure the background doesn't start as black
@@ -122,6 +148,8 @@ void LockWindowTest::testBlankScreen()
     QVERIFY(isColored(Qt::red, 0, 0, 100, 100));
 
     ScreenLocker::X11Locker lockWindow;
+    QFETCH(bool, compositeOverlay);
+    lockWindow.setUseCompositeOverlay(compositeOverlay);
     lockWindow.showLockWindow();
 
     // the screen used to be blanked once the first lock window gets mapped, so let's create one
@@ -265,5 +293,118 @@ void LockWindowTest::testEmergencyShow()
     lockWindow.hideLockWindow();
 }
 
+void LockWindowTest::benchmarkMotionForwarding()
+{
+    ScreenLocker::X11Locker lockWindow;
+    lockWindow.showLockWindow();
+
+    // a few lock windows like a greeter on a multi screen setup would create
+    xcb_atom_t atom = screenLockerAtom();
+    QVERIFY(atom != XCB_ATOM_NONE);
+    xcb_connection_t *c = QX11Info::connection();
+    QVector<QWindow *> fakeWindows;
+    for (int i = 0; i < 3; ++i) {
+        QWindow *fakeWindow = new QWindow;
+        fakeWindow->setFlags(Qt::X11BypassWindowManagerHint);
+        fakeWindow->setGeometry(i * 100, 0, 100, 100);
+        fakeWindow->create();
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, fakeWindow->winId(), atom, atom, 32, 0, nullptr);
+        fakeWindow->show();
+        lockWindow.addAllowedWindow(fakeWindow->winId());
+        fakeWindows << fakeWindow;
+    }
+    xcb_flush(c);
+    QTest::qWait(1000);
+
+    // motion events on the last window, so that every lock window gets checked
+    xcb_motion_notify_event_t event = {};
+    event.response_type = XCB_MOTION_NOTIFY;
+    event.root = QX11Info::appRootWindow();
+    event.event = QX11Info::appRootWindow();
+    event.same_screen = true;
+    int step = 0;
+    QBENCHMARK {
+        event.root_x = event.event_x = 200 + step % 100;
+        event.root_y = event.event_y = step % 100;
+        ++step;
+        QVERIFY(lockWindow.nativeEventFilter(QByteArrayLiteral("xcb_generic_event_t"), &event, nullptr));
+    }
+    // forwards the compressed motion
+    QCoreApplication::processEvents();
+    xcb_flush(c);
+
+    const auto statistics = lockWindow.inputStatistics();
+    QVERIFY(statistics.received >= quint64(step));
+    // all motion events in one event loop iteration end up in one forwarded event
+    QCOMPARE(statistics.forwarded + statistics.dropped, statistics.received);
+
+    qDeleteAll(fakeWindows);
+    lockWindow.hideLockWindow();
+}
+
+void LockWindowTest::benchmarkInitialize_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::newRow("10 windows") << 10;
+    QTest::newRow("100 windows") << 100;
+    QTest::newRow("1000 windows") << 1000;
+    QTest::newRow("5000 windows") << 5000;
+}
+
+void LockWindowTest::benchmarkInitialize()
+{
+    // a session with many toplevel windows, X11Locker reads the state of each of them when created
+    QFETCH(int, windowCount);
+
+    // the first X11Locker also fills caches of Qt
+    {
+        ScreenLocker::X11Locker lockWindow;
+    }
+    s_roundTrips = 0;
+    {
+        ScreenLocker::X11Locker lockWindow;
+    }
+    const int baseRoundTrips = s_roundTrips;
+
+    xcb_connection_t *c = QX11Info::connection();
+    QVector<xcb_window_t> windows;
+    for (int i = 0; i < windowCount; ++i) {
+        const xcb_window_t window = xcb_generate_id(c);
+        xcb_create_window(c,
+                          XCB_COPY_FROM_PARENT,
+                          window,
+                          QX11Info::appRootWindow(),
+                          0,
+                          0,
+                          1,
+                          1,
+                          0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          XCB_COPY_FROM_PARENT,
+                          0,
+                          nullptr);
+        windows << window;
+    }
+    xcb_flush(c);
+
+    // the additional windows must not cost any further round trip
+    s_roundTrips = 0;
+    {
+        ScreenLocker::X11Locker lockWindow;
+    }
+    qDebug() << "Round trips with" << windowCount << "additional windows:" << s_roundTrips;
+    QCOMPARE(s_roundTrips.load(), baseRoundTrips);
+
+    QBENCHMARK {
+        ScreenLocker::X11Locker lockWindow;
+    }
+
+    for (xcb_window_t window : qAsConst(windows)) {
+        xcb_destroy_window(c, window);
+    }
+    xcb_flush(c);
+}
+
 QTEST_MAIN(LockWindowTest)
 #include "x11lockertest.moc"
@@ -0,0 +1,199 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// own
+#include "../x11windowstack.h"
+// Qt
+#include <QtTest>
+
+using ScreenLocker::X11WindowStack;
+
+class X11WindowStackTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testAddRemove();
+    void testViewable();
+    void testRestackAbove();
+    void testCirculate();
+    void testIsOnTop();
+    void benchmarkEventStream();
+};
+
+void X11WindowStackTest::testAddRemove()
+{
+    X11WindowStack stack;
+    QVERIFY(stack.addOnTop(1, false));
+    QVERIFY(stack.addOnTop(2, true));
+    QVERIFY(stack.addOnTop(3, false));
+    QVERIFY(!stack.addOnTop(2, false));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({1, 2, 3}));
+    QCOMPARE(stack.size(), 3);
+
+    QVERIFY(stack.remove(2));
+    QVERIFY(!stack.remove(2));
+    QVERIFY(!stack.contains(2));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({1, 3}));
+
+    stack.clear();
+    QCOMPARE(stack.size(), 0);
+    QVERIFY(stack.windows().isEmpty());
+}
+
+void X11WindowStackTest::testViewable()
+{
+    X11WindowStack stack;
+    stack.addOnTop(1, false);
+    QVERIFY(!stack.isViewable(1));
+    QVERIFY(stack.setViewable(1, true));
+    QVERIFY(stack.isViewable(1));
+    QVERIFY(!stack.setViewable(2, true));
+    QVERIFY(!stack.isViewable(2));
+}
+
+void X11WindowStackTest::testRestackAbove()
+{
+    X11WindowStack stack;
+    for (xcb_window_t window = 1; window <= 4; ++window) {
+        stack.addOnTop(window, true);
+    }
+    // move down
+    QVERIFY(stack.restackAbove(4, 1));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({1, 4, 2, 3}));
+    // move up
+    QVERIFY(stack.restackAbove(1, 3));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({4, 2, 3, 1}));
+    // already in place
+    QVERIFY(stack.restackAbove(1, 3));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({4, 2, 3, 1}));
+    // no sibling means the bottom
+    QVERIFY(stack.restackAbove(3, XCB_WINDOW_NONE));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({3, 4, 2, 1}));
+    // unknown windows don't change anything
+    QVERIFY(!stack.restackAbove(5, 3));
+    QVERIFY(!stack.restackAbove(3, 5));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({3, 4, 2, 1}));
+    // the moved windows can still be found
+    QVERIFY(stack.remove(4));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({3, 2, 1}));
+}
+
+void X11WindowStackTest::testCirculate()
+{
+    X11WindowStack stack;
+    for (xcb_window_t window = 1; window <= 3; ++window) {
+        stack.addOnTop(window, true);
+    }
+    QVERIFY(stack.moveToTop(1));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({2, 3, 1}));
+    QVERIFY(stack.moveToBottom(3));
+    QCOMPARE(stack.windows(), QVector<xcb_window_t>({3, 2, 1}));
+    QVERIFY(!stack.moveToTop(4));
+    QVERIFY(!stack.moveToBottom(4));
+}
+
+void X11WindowStackTest::testIsOnTop()
+{
+    X11WindowStack stack;
+    stack.addOnTop(1, true);
+    stack.addOnTop(2, true);
+    stack.addOnTop(3, true);
+    QVERIFY(stack.isOnTop({3, 2}));
+    QVERIFY(stack.isOnTop({3, 2, 1}));
+    QVERIFY(!stack.isOnTop({2, 3}));
+    QVERIFY(!stack.isOnTop({2, 1}));
+    QVERIFY(!stack.isOnTop({3, 4}));
+
+    // windows which are not viewable don't cover anything
+    stack.addOnTop(4, false);
+    QVERIFY(stack.isOnTop({3, 2}));
+    stack.setViewable(4, true);
+    QVERIFY(!stack.isOnTop({3, 2}));
+    stack.setViewable(4, false);
+    stack.restackAbove(4, 3);
+    stack.setViewable(2, false);
+    QVERIFY(!stack.isOnTop({2, 3}));
+    QVERIFY(stack.isOnTop({3, 1}));
+}
+
+void X11WindowStackTest::benchmarkEventStream()
+{
+    // Replays the root window notifies of a session with a few thousand toplevels where
+    // tooltips and notifications keep getting created, mapped, raised, unmapped and destroyed.
+    enum class Notify {
+        Create,
+        Map,
+        Configure,
+        Unmap,
+        Destroy,
+        Circulate,
+    };
+    struct Event {
+        Notify type;
+        xcb_window_t window;
+        xcb_window_t sibling;
+    };
+    const xcb_window_t toplevels = 4000;
+    QVector<Event> events;
+    QRandomGenerator random(42);
+    xcb_window_t nextWindow = toplevels + 1;
+    for (int i = 0; i < 10000; ++i) {
+        const xcb_window_t popup = nextWindow++;
+        const xcb_window_t existing = random.bounded(toplevels) + 1;
+        events << Event{Notify::Create, popup, XCB_WINDOW_NONE};
+        events << Event{Notify::Map, popup, XCB_WINDOW_NONE};
+        events << Event{Notify::Configure, popup, existing};
+        events << Event{Notify::Configure, existing, popup};
+        events << Event{Notify::Circulate, existing, XCB_WINDOW_NONE};
+        events << Event{Notify::Unmap, popup, XCB_WINDOW_NONE};
+        events << Event{Notify::Destroy, popup, XCB_WINDOW_NONE};
+    }
+
+    X11WindowStack stack;
+    QBENCHMARK {
+        stack.clear();
+        for (xcb_window_t window = 1; window <= toplevels; ++window) {
+            stack.addOnTop(window, true);
+        }
+        for (const Event &event : qAsConst(events)) {
+            switch (event.type) {
+            case Notify::Create:
+                stack.addOnTop(event.window, false);
+                break;
+            case Notify::Map:
+                stack.setViewable(event.window, true);
+                break;
+            case Notify::Configure:
+                stack.restackAbove(event.window, event.sibling);
+                break;
+            case Notify::Unmap:
+                stack.setViewable(event.window, false);
+                break;
+            case Notify::Destroy:
+                stack.remove(event.window);
+                break;
+            case Notify::Circulate:
+                stack.moveToTop(event.window);
+                break;
+            }
+        }
+    }
+    QCOMPARE(stack.size(), int(toplevels));
+}
+
+QTEST_GUILESS_MAIN(X11WindowStackTest)
+#include "x11windowstacktest.moc"
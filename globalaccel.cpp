@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDBusConnection>
 #include <QDBusMessage>
 #include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
 #include <QKeyEvent>
 #include <QRegularExpression>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -71,22 +72,66 @@ static void calculateGrabMasks()
 GlobalAccel::GlobalAccel(QObject *parent)
     : QObject(parent)
 {
+    // the cached shortcuts are outdated once kglobalaccel reports a change or gets restarted
+    QDBusConnection::sessionBus().connect(s_kglobalAccelService,
+                                          QStringLiteral("/kglobalaccel"),
+                                          QStringLiteral("org.kde.KGlobalAccel"),
+                                          QStringLiteral("yourShortcutGotChanged"),
+                                          this,
+                                          SLOT(invalidate()));
+    QDBusConnection::sessionBus().connect(s_kglobalAccelService,
+                                          QStringLiteral("/kglobalaccel"),
+                                          QStringLiteral("org.kde.KGlobalAccel"),
+                                          QStringLiteral("yourShortcutsChanged"),
+                                          this,
+                                          SLOT(invalidate()));
+    QDBusServiceWatcher *serviceWatcher =
+        new QDBusServiceWatcher(s_kglobalAccelService, QDBusConnection::sessionBus(), QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(serviceWatcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &GlobalAccel::invalidate);
+}
+
+GlobalAccel::~GlobalAccel()
+{
+    if (m_keySymbols) {
+        xcb_key_symbols_free(m_keySymbols);
+    }
 }
 
 void GlobalAccel::prepare()
 {
+    if (QX11Info::isPlatformX11() && !m_keySymbols) {
+        m_keySymbols = xcb_key_symbols_alloc(QX11Info::connection());
+        calculateGrabMasks();
+    }
     // recursion check
     if (m_updatingInformation) {
         return;
     }
-    // first ensure that we don't have some left over
-    release();
+    refresh();
+}
 
-    if (QX11Info::isPlatformX11()) {
-        m_keySymbols = xcb_key_symbols_alloc(QX11Info::connection());
-        calculateGrabMasks();
+void GlobalAccel::invalidate()
+{
+    m_valid = false;
+    if (m_updatingInformation) {
+        // the replies in flight might predate the change
+        m_refreshPending = true;
+        return;
+    }
+    refresh();
+}
+
+void GlobalAccel::keymapChanged(xcb_mapping_notify_event_t *event)
+{
+    if (!m_keySymbols) {
+        return;
     }
+    xcb_refresh_keyboard_mapping(m_keySymbols, event);
+    calculateGrabMasks();
+}
 
+void GlobalAccel::refresh()
+{
     // fetch all components from KGlobalAccel
     m_updatingInformation++;
     auto message = QDBusMessage::createMethodCall(s_kglobalAccelService,
@@ -103,23 +148,28 @@ void GlobalAccel::components(QDBusPendingCallWatcher *self)
     QDBusPendingReply<QList<QDBusObjectPath>> reply = *self;
     self->deleteLater();
     if (!reply.isValid()) {
-        m_updatingInformation--;
+        updateFinished();
         return;
     }
     // go through all components, check whether they are in our whitelist
-    // if they are whitelisted we check whether they are active
+    QStringList whitelisted;
     for (const auto &path : reply.value()) {
-        const QString objectPath = path.path();
-        bool whitelisted = false;
-        for (auto it = s_shortcutWhitelist.begin(); it != s_shortcutWhitelist.end(); ++it) {
-            if (objectPath == it.key()) {
-                whitelisted = true;
-                break;
-            }
-        }
-        if (!whitelisted) {
-            continue;
+        if (s_shortcutWhitelist.contains(path.path())) {
+            whitelisted << path.path();
         }
+    }
+    if (m_valid && whitelisted == m_components) {
+        // no component appeared or vanished since the shortcuts got cached
+        updateFinished();
+        return;
+    }
+    m_components = whitelisted;
+    m_fetchingShortcuts = true;
+    m_fetchComplete = true;
+    m_fetchedShortcuts.clear();
+
+    // if they are whitelisted we check whether they are active
+    for (const QString &objectPath : qAsConst(whitelisted)) {
         auto message = QDBusMessage::createMethodCall(s_kglobalAccelService, objectPath, s_componentInterface, QStringLiteral("isActive"));
         QDBusPendingReply<bool> async = QDBusConnection::sessionBus().asyncCall(message);
         QDBusPendingCallWatcher *callWatcher = new QDBusPendingCallWatcher(async, this);
@@ -127,9 +177,10 @@ void GlobalAccel::components(QDBusPendingCallWatcher *self)
         connect(callWatcher, &QDBusPendingCallWatcher::finished, this, [this, objectPath](QDBusPendingCallWatcher *self) {
             QDBusPendingReply<bool> reply = *self;
             self->deleteLater();
-            // filter out inactive components
+            // filter out inactive components, they might become active later on
             if (!reply.isValid() || !reply.value()) {
-                m_updatingInformation--;
+                m_fetchComplete = false;
+                updateFinished();
                 return;
             }
 
@@ -138,10 +189,11 @@ void GlobalAccel::components(QDBusPendingCallWatcher *self)
             QDBusPendingReply<QList<KGlobalShortcutInfo>> async = QDBusConnection::sessionBus().asyncCall(message);
             QDBusPendingCallWatcher *callWatcher = new QDBusPendingCallWatcher(async, this);
             connect(callWatcher, &QDBusPendingCallWatcher::finished, this, [this, objectPath](QDBusPendingCallWatcher *self) {
-                m_updatingInformation--;
                 QDBusPendingReply<QList<KGlobalShortcutInfo>> reply = *self;
                 self->deleteLater();
                 if (!reply.isValid()) {
+                    m_fetchComplete = false;
+                    updateFinished();
                     return;
                 }
                 // restrict to whitelist
@@ -149,6 +201,7 @@ void GlobalAccel::components(QDBusPendingCallWatcher *self)
                 auto whitelist = s_shortcutWhitelist.constFind(objectPath);
                 if (whitelist == s_shortcutWhitelist.constEnd()) {
                     // this should not happen, just for safety
+                    updateFinished();
                     return;
                 }
                 const auto s = reply.value();
@@ -158,19 +211,42 @@ void GlobalAccel::components(QDBusPendingCallWatcher *self)
                         infos.append(*it);
                     }
                 }
-                m_shortcuts.insert(objectPath, infos);
+                m_fetchedShortcuts.insert(objectPath, infos);
+                updateFinished();
             });
         });
     }
-    m_updatingInformation--;
+    updateFinished();
 }
 
-void GlobalAccel::release()
+void GlobalAccel::updateFinished()
 {
-    m_shortcuts.clear();
-    if (m_keySymbols) {
-        xcb_key_symbols_free(m_keySymbols);
-        m_keySymbols = nullptr;
+    if (--m_updatingInformation > 0) {
+        return;
+    }
+    if (m_fetchingShortcuts) {
+        // replace the cache at once, the previous shortcuts keep working till here
+        m_fetchingShortcuts = false;
+        m_shortcuts = m_fetchedShortcuts;
+        m_fetchedShortcuts.clear();
+        // only a complete fetch can be kept, otherwise the next prepare fetches again
+        m_valid = m_fetchComplete && !m_refreshPending;
+        updateIndex();
+    }
+    if (m_refreshPending) {
+        m_refreshPending = false;
+        refresh();
+    }
+}
+
+void GlobalAccel::updateIndex()
+{
+    // rebuilt in the order of the components, so that the first matching shortcut wins
+    m_index.clear();
+    for (auto it = m_shortcuts.constBegin(); it != m_shortcuts.constEnd(); ++it) {
+        for (const auto &info : it.value()) {
+            m_index.add(it.key(), info.uniqueName(), info.keys());
+        }
     }
 }
 
@@ -190,19 +266,7 @@ bool GlobalAccel::keyEvent(QKeyEvent *event)
         return false;
     }
 
-    const QKeySequence seq(keyCodeQt | keyModQt);
-    // let's check whether we have a mapping shortcut
-    for (auto it = m_shortcuts.constBegin(); it != m_shortcuts.constEnd(); ++it) {
-        for (const auto &info : it.value()) {
-            if (info.keys().contains(seq)) {
-                auto signal = QDBusMessage::createMethodCall(s_kglobalAccelService, it.key(), s_componentInterface, QStringLiteral("invokeShortcut"));
-                signal.setArguments(QList<QVariant>{QVariant(info.uniqueName())});
-                QDBusConnection::sessionBus().asyncCall(signal);
-                return true;
-            }
-        }
-    }
-    return false;
+    return invokeShortcut(keyCodeQt | keyModQt);
 }
 
 bool GlobalAccel::checkKeyPress(xcb_key_press_event_t *event)
@@ -254,17 +318,17 @@ bool GlobalAccel::checkKeyPress(xcb_key_press_event_t *event)
         return false;
     }
 
-    const QKeySequence seq(keyCodeQt | keyModQt);
-    // let's check whether we have a mapping shortcut
-    for (auto it = m_shortcuts.begin(); it != m_shortcuts.end(); ++it) {
-        for (const auto &info : it.value()) {
-            if (info.keys().contains(seq)) {
-                auto signal = QDBusMessage::createMethodCall(s_kglobalAccelService, it.key(), s_componentInterface, QStringLiteral("invokeShortcut"));
-                signal.setArguments(QList<QVariant>{QVariant(info.uniqueName())});
-                QDBusConnection::sessionBus().asyncCall(signal);
-                return true;
-            }
-        }
+    return invokeShortcut(keyCodeQt | keyModQt);
+}
+
+bool GlobalAccel::invokeShortcut(int keyQt)
+{
+    const GlobalShortcutIndex::Shortcut *shortcut = m_index.find(keyQt);
+    if (!shortcut) {
+        return false;
     }
-    return false;
+    auto signal = QDBusMessage::createMethodCall(s_kglobalAccelService, shortcut->componentPath, s_componentInterface, QStringLiteral("invokeShortcut"));
+    signal.setArguments(QList<QVariant>{QVariant(shortcut->uniqueName)});
+    QDBusConnection::sessionBus().asyncCall(signal);
+    return true;
 }
@@ -20,15 +20,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef GLOBALACCEL_H
 #define GLOBALACCEL_H
 
+#include "globalshortcutindex.h"
+
 #include <KGlobalShortcutInfo>
 
 #include <QMap>
 #include <QObject>
+#include <QStringList>
 
 class QDBusPendingCallWatcher;
 class QKeyEvent;
 
 struct xcb_key_press_event_t;
+struct xcb_mapping_notify_event_t;
 typedef struct _XCBKeySymbols xcb_key_symbols_t;
 
 /**
@@ -42,17 +46,16 @@ typedef struct _XCBKeySymbols xcb_key_symbols_t;
  * This class circumvents the problem by interacting with KGlobalAccel when the screen is locked
  * to still allow a few white listed shortcuts (like volume control) to function.
  *
- * As the screen is locked we can operate on a few assumptions which simplifies the interaction:
- * shortcuts won't change. The user cannot interact with the system thus the global shortcut won't
- * change while the screen is locked. This allows us to fetch the allowed shortcut information from
- * KGlobalAcceld when the screen gets locked and keep these information around till the screen is
- * unlocked. We do not need to update the information while the screen is locked.
+ * The allowed shortcut information is fetched from KGlobalAcceld once and kept for the whole
+ * session, so that the shortcuts work right when the screen gets locked. It is fetched again
+ * when KGlobalAcceld reports changed shortcuts or gets restarted. Each time the screen gets
+ * locked a single call checks whether a white listed component appeared or vanished. If a
+ * white listed component was not active yet or did not reply, the cache is incomplete and
+ * gets fetched again on each lock till it is complete.
  *
  * As the information is fetched in an async way from KGlobalAcceld there is a short time window
- * when the screen is locked, but the shortcut information is not fetched. This is considered a
- * not relevant corner case as we can assume that right when the screen locks (due to e.g. idle)
- * no user is in front of the system and is not able to press the shortcut or that the user directly
- * wants to cancel the lock screen again (grace time).
+ * after the start of the session in which the shortcut information is not fetched yet. This is
+ * considered a not relevant corner case.
  *
  * Components are just registered by name in KGlobalAccel. This would in theory allow a malicious
  * application to register under a white listed name with white listed shortcuts and bind enough
@@ -66,15 +69,17 @@ class GlobalAccel : public QObject
     Q_OBJECT
 public:
     explicit GlobalAccel(QObject *parent = nullptr);
+    ~GlobalAccel() override;
 
     /**
-     * Starts interacting with KGlobalAccel and fetches the up-to-date shortcut information.
+     * Starts interacting with KGlobalAccel. Fetches the shortcut information unless the
+     * cached one is still up-to-date.
      **/
     void prepare();
     /**
-     * Discards all knowing shortcut information.
+     * Updates the key symbols after the keyboard mapping changed.
      **/
-    void release();
+    void keymapChanged(xcb_mapping_notify_event_t *event);
 
     /**
      * Checks whether a global shortcut is triggered for the given @p event.
@@ -85,8 +90,25 @@ public:
 
     bool keyEvent(QKeyEvent *event);
 
+private Q_SLOTS:
+    /**
+     * Marks the cached shortcut information as outdated and fetches it again.
+     **/
+    void invalidate();
+
 private:
+    void refresh();
     void components(QDBusPendingCallWatcher *watcher);
+    /**
+     * Called for each finished DBus call, replaces the cached shortcuts once
+     * all calls finished.
+     **/
+    void updateFinished();
+    void updateIndex();
+    /**
+     * Invokes the shortcut of @p keyQt if there is one.
+     **/
+    bool invokeShortcut(int keyQt);
     /**
      * Recursion check: for each DBus call to KGlobalAccel this counter is
      * increased, on each reply decreased. As long as we have running DBus
@@ -103,6 +125,25 @@ private:
      * allowed shortcuts.
      **/
     QMap<QString, QList<KGlobalShortcutInfo>> m_shortcuts;
+    /**
+     * The shortcuts of the fetch in progress, they replace m_shortcuts once complete.
+     **/
+    QMap<QString, QList<KGlobalShortcutInfo>> m_fetchedShortcuts;
+    /**
+     * The white listed components the cached shortcuts got fetched from.
+     **/
+    QStringList m_components;
+    bool m_valid = false;
+    bool m_fetchingShortcuts = false;
+    /**
+     * Whether all white listed components of the fetch in progress were active and replied.
+     **/
+    bool m_fetchComplete = false;
+    bool m_refreshPending = false;
+    /**
+     * The keys of m_shortcuts, looked up on every key press.
+     **/
+    GlobalShortcutIndex m_index;
     xcb_key_symbols_t *m_keySymbols = nullptr;
 };
 
@@ -0,0 +1,59 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "globalshortcutindex.h"
+
+void GlobalShortcutIndex::add(const QString &componentPath, const QString &uniqueName, const QList<QKeySequence> &keys)
+{
+    for (const QKeySequence &sequence : keys) {
+        if (sequence.count() != 1) {
+            continue;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        const int keyQt = sequence[0].toCombined();
+#else
+        const int keyQt = sequence[0];
+#endif
+        if (!m_shortcuts.contains(keyQt)) {
+            m_shortcuts.insert(keyQt, Shortcut{componentPath, uniqueName});
+        }
+    }
+}
+
+const GlobalShortcutIndex::Shortcut *GlobalShortcutIndex::find(int keyQt) const
+{
+    auto it = m_shortcuts.constFind(keyQt);
+    if (it == m_shortcuts.constEnd()) {
+        return nullptr;
+    }
+    return &it.value();
+}
+
+void GlobalShortcutIndex::clear()
+{
+    m_shortcuts.clear();
+}
+
+int GlobalShortcutIndex::size() const
+{
+    return m_shortcuts.size();
+}
+
+bool GlobalShortcutIndex::isEmpty() const
+{
+    return m_shortcuts.isEmpty();
+}
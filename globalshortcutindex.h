@@ -0,0 +1,61 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef GLOBALSHORTCUTINDEX_H
+#define GLOBALSHORTCUTINDEX_H
+
+#include <QHash>
+#include <QKeySequence>
+#include <QList>
+#include <QString>
+
+/**
+ * Maps a key combination, the Qt key code together with the modifiers, to the global shortcut
+ * it triggers. Looking up a key press does not depend on the number of shortcuts and does not
+ * allocate.
+ **/
+class GlobalShortcutIndex
+{
+public:
+    struct Shortcut {
+        /**
+         * DBus object path of the KGlobalAccel component
+         **/
+        QString componentPath;
+        QString uniqueName;
+    };
+
+    /**
+     * Adds the single key sequences of @p keys. A key combination which is already taken keeps
+     * its shortcut. Sequences of multiple key presses are skipped, as only a single key press
+     * gets checked for a shortcut.
+     **/
+    void add(const QString &componentPath, const QString &uniqueName, const QList<QKeySequence> &keys);
+    /**
+     * @returns the shortcut triggered by @p keyQt or @c nullptr
+     **/
+    const Shortcut *find(int keyQt) const;
+
+    void clear();
+    int size() const;
+    bool isEmpty() const;
+
+private:
+    QHash<int, Shortcut> m_shortcuts;
+};
+
+#endif
@@ -53,6 +53,7 @@ Item {
             anchors.horizontalCenter: parent.horizontalCenter
             font.bold: true
             Behavior on opacity {
+                enabled: !kscreenlocker_throttled
                 NumberAnimation {
                     duration: 250
                 }
@@ -68,6 +69,7 @@ Item {
             height: capsLockOn ? paintedHeight : 0
             font.bold: true
             Behavior on opacity {
+                enabled: !kscreenlocker_throttled
                 NumberAnimation {
                     duration: 250
                 }
@@ -62,13 +62,13 @@ Item {
         height: mainStack.currentPage.implicitHeight + margins.top + margins.bottom
 
         Behavior on height {
-            enabled: mainStack.currentPage != null
+            enabled: mainStack.currentPage != null && !kscreenlocker_throttled
             NumberAnimation {
                 duration: 250
             }
         }
         Behavior on width {
-            enabled: mainStack.currentPage != null
+            enabled: mainStack.currentPage != null && !kscreenlocker_throttled
             NumberAnimation {
                 duration: 250
             }
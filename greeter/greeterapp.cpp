@@ -52,12 +52,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QAbstractNativeEventFilter>
 #include <QClipboard>
 #include <QDBusConnection>
+#include <QDateTime>
+#include <QEventLoop>
 #include <QKeyEvent>
 #include <QMimeData>
 #include <QThread>
 #include <QTimer>
 #include <qscreen.h>
 
+#include <iostream>
+#include <time.h>
+
+#include <QQmlComponent>
 #include <QQmlContext>
 #include <QQmlEngine>
 #include <QQmlExpression>
@@ -89,6 +95,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 static const QString s_plasmaShellService = QStringLiteral("org.kde.plasmashell");
 static const QString s_osdServicePath = QStringLiteral("/org/kde/osdService");
 static const QString s_osdServiceInterface = QStringLiteral("org.kde.osdService");
+static const QUrl s_fallbackUrl(QStringLiteral("qrc:/fallbacktheme/LockScreen.qml"));
+// milliseconds to wait for the first view's frame before creating the views for the other screens
+static const int s_firstFrameTimeout = 200;
 
 namespace ScreenLocker
 {
@@ -141,6 +150,9 @@ public:
     }
 };
 
+// While throttled the views present at most one frame per interval
+static const int s_throttledFrameInterval = 250;
+
 // App
 UnlockApp::UnlockApp(int &argc, char **argv)
     : QGuiApplication(argc, argv)
@@ -195,6 +207,10 @@ void UnlockApp::initialize()
     m_resetRequestIgnoreTimer->setInterval(2000);
     connect(m_resetRequestIgnoreTimer, &QTimer::timeout, this, &UnlockApp::resetRequestIgnore);
 
+    m_throttledUpdateTimer = new QTimer(this);
+    m_throttledUpdateTimer->setInterval(s_throttledFrameInterval);
+    connect(m_throttledUpdateTimer, &QTimer::timeout, this, &UnlockApp::flushThrottledUpdates);
+
     KScreenSaverSettingsBase::self()->load();
     KPackage::Package package = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Plasma/LookAndFeel"));
     KConfigGroup cg(KSharedConfig::openConfig(QStringLiteral("kdeglobals")), "KDE");
@@ -295,7 +311,7 @@ void UnlockApp::setWallpaperItemProperties(KDeclarative::QmlObjectSharedEngine *
         qCWarning(KSCREENLOCKER_GREET) << "Wallpaper needs to be a QtQuick Item";
         return;
     }
-    item->setParentItem(view->rootObject());
+    item->setParentItem(mainItem(view));
     item->setZ(-1000);
 
     // set anchors
@@ -304,12 +320,82 @@ void UnlockApp::setWallpaperItemProperties(KDeclarative::QmlObjectSharedEngine *
     prop.write(expr.evaluate());
 }
 
+bool UnlockApp::warmupQmlCache()
+{
+    // Only compiling the lock screen is needed: the compilation units of the main script and
+    // of all QML types it imports get written to the QML disk cache, which the next greeter
+    // start picks up instead of compiling again.
+    NoAccessNetworkAccessManagerFactory networkAccessManagerFactory;
+    QQmlEngine engine;
+    engine.rootContext()->setContextObject(new KLocalizedContext(&engine));
+    engine.setNetworkAccessManagerFactory(&networkAccessManagerFactory);
+
+    QQmlComponent component(&engine);
+    component.loadUrl(m_mainQmlPath, QQmlComponent::PreferSynchronous);
+    if (component.isLoading()) {
+        QEventLoop loop;
+        connect(&component, &QQmlComponent::statusChanged, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    if (component.isError()) {
+        qCWarning(KSCREENLOCKER_GREET) << "Failed to compile lockscreen QML" << m_mainQmlPath << component.errors();
+        return false;
+    }
+    qCDebug(KSCREENLOCKER_GREET) << "Compiled lockscreen QML" << m_mainQmlPath;
+    return true;
+}
+
 void UnlockApp::initialViewSetup()
 {
-    for (QScreen *screen : screens()) {
-        handleScreen(screen);
+    // Only the screen the user is looking at gets its view right away. The other screens stay
+    // covered by ksld's lock window till their views got created in later event loop iterations.
+    QScreen *activeScreen = screenAt(QCursor::pos());
+    const auto allScreens = screens();
+    for (QScreen *screen : allScreens) {
+        if (screen == activeScreen) {
+            m_pendingScreens.prepend(screen);
+        } else {
+            m_pendingScreens.append(screen);
+        }
     }
     connect(this, &UnlockApp::screenAdded, this, &UnlockApp::handleScreen);
+
+    m_pendingViewsTimer = new QTimer(this);
+    m_pendingViewsTimer->setSingleShot(true);
+    connect(m_pendingViewsTimer, &QTimer::timeout, this, &UnlockApp::createPendingView);
+
+    createPendingView();
+    if (m_pendingScreens.isEmpty()) {
+        return;
+    }
+    if (!m_standby && !m_views.isEmpty()) {
+        // let the first view present a frame before keeping the main thread busy with the next ones
+        KQuickAddons::QuickViewSharedEngine *view = m_views.first();
+        connect(view, &QQuickWindow::frameSwapped, m_pendingViewsTimer, [this, view]() {
+            disconnect(view, &QQuickWindow::frameSwapped, m_pendingViewsTimer, nullptr);
+            m_pendingViewsTimer->start(0);
+        });
+        // don't leave the other screens without lock screen if that frame never comes
+        m_pendingViewsTimer->start(s_firstFrameTimeout);
+    }
+}
+
+void UnlockApp::createPendingView()
+{
+    while (!m_pendingScreens.isEmpty()) {
+        const QPointer<QScreen> screen = m_pendingScreens.takeFirst();
+        // the screen might have been removed in the meantime
+        if (screen) {
+            handleScreen(screen);
+            break;
+        }
+    }
+    if (m_pendingScreens.isEmpty()) {
+        // the views created so far might all have presented already
+        sendReady();
+    } else {
+        m_pendingViewsTimer->start(0);
+    }
 }
 
 void UnlockApp::handleScreen(QScreen *screen)
@@ -324,10 +410,72 @@ void UnlockApp::handleScreen(QScreen *screen)
             return;
         }
         m_views.removeOne(view);
+        m_firstFrames.remove(view);
         delete view;
+        // the removed screen might have been the last one ksld was waiting for
+        sendReady();
     });
 }
 
+void UnlockApp::loadMainComponent(QQmlEngine *engine)
+{
+    // the shared engine goes away together with the last view, and the component with it
+    if (m_mainComponent) {
+        return;
+    }
+    m_mainComponent = new QQmlComponent(engine, m_mainQmlPath, QQmlComponent::PreferSynchronous, engine);
+    if (m_mainComponent->isError()) {
+        loadFallbackComponent(engine);
+    }
+}
+
+void UnlockApp::loadFallbackComponent(QQmlEngine *engine)
+{
+    if (m_mainQmlPath == s_fallbackUrl) {
+        return;
+    }
+    qCWarning(KSCREENLOCKER_GREET) << "Failed to load lockscreen QML, falling back to built-in locker" << m_mainComponent->errors();
+    delete m_mainComponent;
+    m_mainQmlPath = s_fallbackUrl;
+    m_mainComponent = new QQmlComponent(engine, m_mainQmlPath, QQmlComponent::PreferSynchronous, engine);
+}
+
+QQuickItem *UnlockApp::createMainItem(KQuickAddons::QuickViewSharedEngine *view)
+{
+    loadMainComponent(view->engine());
+    QObject *object = m_mainComponent->beginCreate(view->rootContext());
+    auto item = qobject_cast<QQuickItem *>(object);
+    if (!item) {
+        // on error, load the fallback lockscreen to not lock the user out of the system
+        if (object) {
+            m_mainComponent->completeCreate();
+            delete object;
+        }
+        if (m_mainQmlPath == s_fallbackUrl) {
+            qCCritical(KSCREENLOCKER_GREET) << "Failed to create the built-in locker" << m_mainComponent->errors();
+            return nullptr;
+        }
+        loadFallbackComponent(view->engine());
+        return createMainItem(view);
+    }
+    // set before the bindings of the lock screen get evaluated for the first time
+    QQmlProperty(item, QStringLiteral("locked")).write(m_immediateLock || (!m_noLock && !m_delayedLockTimer));
+    QQmlProperty(item, QStringLiteral("suspendToRamSupported")).write(PowerManagement::instance()->canSuspend());
+    QQmlProperty(item, QStringLiteral("suspendToDiskSupported")).write(PowerManagement::instance()->canHibernate());
+    m_mainComponent->completeCreate();
+
+    item->setParent(view->contentItem());
+    item->setParentItem(view->contentItem());
+    QQmlProperty(item, QStringLiteral("anchors.fill")).write(QVariant::fromValue(view->contentItem()));
+    view->setProperty("mainItem", QVariant::fromValue(item));
+    return item;
+}
+
+QQuickItem *UnlockApp::mainItem(KQuickAddons::QuickViewSharedEngine *view)
+{
+    return view->property("mainItem").value<QQuickItem *>();
+}
+
 KQuickAddons::QuickViewSharedEngine *UnlockApp::createViewForScreen(QScreen *screen)
 {
     // create the view
@@ -355,10 +503,8 @@ KQuickAddons::QuickViewSharedEngine *UnlockApp::createViewForScreen(QScreen *scr
         }
     }
 
-    if (m_ksldInterface) {
-        view->create();
-        org_kde_ksld_x11window(m_ksldInterface, view->winId());
-        wl_display_flush(m_ksldConnection->display());
+    if (!m_standby) {
+        announceView(view);
     }
 
     // engine stuff
@@ -377,6 +523,7 @@ KQuickAddons::QuickViewSharedEngine *UnlockApp::createViewForScreen(QScreen *scr
     context->setContextProperty(QStringLiteral("org_kde_plasma_screenlocker_greeter_interfaceVersion"), 2);
     context->setContextProperty(QStringLiteral("org_kde_plasma_screenlocker_greeter_view"), view);
     context->setContextProperty(QStringLiteral("defaultToSwitchUser"), m_defaultToSwitchUser);
+    context->setContextProperty(QStringLiteral("kscreenlocker_throttled"), m_throttled);
     context->setContextProperty(QStringLiteral("config"), m_lnfIntegration->configuration());
 
     auto wallpaperObj = loadWallpaperPlugin(view);
@@ -388,35 +535,19 @@ KQuickAddons::QuickViewSharedEngine *UnlockApp::createViewForScreen(QScreen *scr
         });
     }
 
-    view->setSource(m_mainQmlPath);
-    // on error, load the fallback lockscreen to not lock the user out of the system
-    if (view->status() != QQmlComponent::Ready) {
-        static const QUrl fallbackUrl(QUrl(QStringLiteral("qrc:/fallbacktheme/LockScreen.qml")));
-
-        qCWarning(KSCREENLOCKER_GREET) << "Failed to load lockscreen QML, falling back to built-in locker";
-
-        m_mainQmlPath = fallbackUrl;
-        view->setSource(fallbackUrl);
-    }
-    view->setResizeMode(KQuickAddons::QuickViewSharedEngine::SizeRootObjectToView);
+    // every view instantiates the lock screen compiled once in loadMainComponent
+    QQuickItem *root = createMainItem(view);
 
     // we need to set this wallpaper properties separately after the lockscreen QML is loaded
     // this is because we need to anchor to the view that gets loaded
     setWallpaperItemProperties(wallpaperObj, view);
+    updateWallpaperVisibility(view);
 
-    QQmlProperty lockProperty(view->rootObject(), QStringLiteral("locked"));
-    lockProperty.write(m_immediateLock || (!m_noLock && !m_delayedLockTimer));
-
-    QQmlProperty sleepProperty(view->rootObject(), QStringLiteral("suspendToRamSupported"));
-    sleepProperty.write(PowerManagement::instance()->canSuspend());
-    if (view->rootObject() && view->rootObject()->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("suspendToRam()").constData()) != -1) {
-        connect(view->rootObject(), SIGNAL(suspendToRam()), SLOT(suspendToRam()));
+    if (root && root->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("suspendToRam()").constData()) != -1) {
+        connect(root, SIGNAL(suspendToRam()), SLOT(suspendToRam()));
     }
-
-    QQmlProperty hibernateProperty(view->rootObject(), QStringLiteral("suspendToDiskSupported"));
-    hibernateProperty.write(PowerManagement::instance()->canHibernate());
-    if (view->rootObject() && view->rootObject()->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("suspendToDisk()").constData()) != -1) {
-        connect(view->rootObject(), SIGNAL(suspendToDisk()), SLOT(suspendToDisk()));
+    if (root && root->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("suspendToDisk()").constData()) != -1) {
+        connect(root, SIGNAL(suspendToDisk()), SLOT(suspendToDisk()));
     }
 
     // verify that the engine's controller didn't change
@@ -430,6 +561,16 @@ KQuickAddons::QuickViewSharedEngine *UnlockApp::createViewForScreen(QScreen *scr
         }
     }
 
+    // in standby mode the view stays hidden till ksld activates us
+    if (!m_standby) {
+        showView(view);
+    }
+
+    return view;
+}
+
+void UnlockApp::showView(KQuickAddons::QuickViewSharedEngine *view)
+{
     // on Wayland we may not use fullscreen as that puts all windows on one screen
     if (m_testing || QX11Info::isPlatformX11()) {
         view->show();
@@ -442,14 +583,31 @@ KQuickAddons::QuickViewSharedEngine *UnlockApp::createViewForScreen(QScreen *scr
         markViewsAsVisible(view);
     };
     connect(view, &QQuickWindow::frameSwapped, this, onFrameSwapped, Qt::QueuedConnection);
+}
 
-    return view;
+void UnlockApp::announceView(KQuickAddons::QuickViewSharedEngine *view)
+{
+    if (!m_ksldInterface) {
+        return;
+    }
+    view->create();
+    org_kde_ksld_x11window(m_ksldInterface, view->winId());
+    wl_display_flush(m_ksldConnection->display());
+}
+
+static quint64 monotonicTimestamp()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
 }
 
 void UnlockApp::markViewsAsVisible(KQuickAddons::QuickViewSharedEngine *view)
 {
     disconnect(view, &QQuickWindow::frameSwapped, this, nullptr);
-    QQmlProperty showProperty(view->rootObject(), QStringLiteral("viewVisible"));
+    m_firstFrames.insert(view, monotonicTimestamp());
+    sendReady();
+    QQmlProperty showProperty(mainItem(view), QStringLiteral("viewVisible"));
     showProperty.write(true);
     // random state update, actually rather required on init only
     QMetaObject::invokeMethod(this, "getFocus", Qt::QueuedConnection);
@@ -469,6 +627,31 @@ void UnlockApp::markViewsAsVisible(KQuickAddons::QuickViewSharedEngine *view)
     QGuiApplication::clipboard()->setMimeData(mime2, QClipboard::Selection);
 }
 
+void UnlockApp::sendReady()
+{
+    if (m_readySent || !m_ksldInterface || m_views.isEmpty() || !m_pendingScreens.isEmpty()) {
+        return;
+    }
+    if (org_kde_ksld_get_version(m_ksldInterface) < ORG_KDE_KSLD_READY_SINCE_VERSION) {
+        return;
+    }
+    wl_array timestamps;
+    wl_array_init(&timestamps);
+    for (KQuickAddons::QuickViewSharedEngine *view : qAsConst(m_views)) {
+        auto it = m_firstFrames.constFind(view);
+        if (it == m_firstFrames.constEnd()) {
+            // not every screen shows the lock screen yet
+            wl_array_release(&timestamps);
+            return;
+        }
+        *static_cast<uint64_t *>(wl_array_add(&timestamps, sizeof(uint64_t))) = it.value();
+    }
+    org_kde_ksld_ready(m_ksldInterface, &timestamps);
+    wl_array_release(&timestamps);
+    wl_display_flush(m_ksldConnection->display());
+    m_readySent = true;
+}
+
 void UnlockApp::getFocus()
 {
     QWindow *activeScreen = getActiveScreen();
@@ -497,7 +680,7 @@ void UnlockApp::setLockedPropertyOnViews()
     m_delayedLockTimer = nullptr;
 
     for (KQuickAddons::QuickViewSharedEngine *view : qAsConst(m_views)) {
-        QQmlProperty lockProperty(view->rootObject(), QStringLiteral("locked"));
+        QQmlProperty lockProperty(mainItem(view), QStringLiteral("locked"));
         lockProperty.write(true);
     }
 }
@@ -575,6 +758,16 @@ void UnlockApp::lockImmediately()
 
 bool UnlockApp::eventFilter(QObject *obj, QEvent *event)
 {
+    if (event->type() == QEvent::UpdateRequest && m_throttled && !m_flushingThrottledUpdates) {
+        // caps both the repaints and the animation ticks, which Qt Quick drives through update requests
+        auto view = qobject_cast<KQuickAddons::QuickViewSharedEngine *>(obj);
+        if (view && m_views.contains(view)) {
+            m_throttledUpdates.insert(view);
+            return true;
+        }
+        return false;
+    }
+
     if (obj != this && event->type() == QEvent::Show) {
         KQuickAddons::QuickViewSharedEngine *view = nullptr;
         for (KQuickAddons::QuickViewSharedEngine *v : qAsConst(m_views)) {
@@ -645,7 +838,7 @@ void UnlockApp::shareEvent(QEvent *e, KQuickAddons::QuickViewSharedEngine *from)
 void UnlockApp::setGraceTime(int milliseconds)
 {
     m_graceTime = milliseconds;
-    if (milliseconds < 0 || m_delayedLockTimer || m_noLock || m_immediateLock) {
+    if (milliseconds <= 0 || m_delayedLockTimer || m_noLock || m_immediateLock) {
         return;
     }
     m_delayedLockTimer = new QTimer(this);
@@ -664,6 +857,89 @@ void UnlockApp::setDefaultToSwitchUser(bool defaultToSwitchUser)
     m_defaultToSwitchUser = defaultToSwitchUser;
 }
 
+void UnlockApp::setStandby(bool standby)
+{
+    m_standby = standby;
+}
+
+void UnlockApp::setThrottled(bool throttled)
+{
+    if (m_throttled == throttled) {
+        return;
+    }
+    m_throttled = throttled;
+    qCDebug(KSCREENLOCKER_GREET) << "Throttled:" << throttled;
+    // the views share the engine and by that the root context
+    if (!m_views.isEmpty()) {
+        m_views.first()->engine()->rootContext()->setContextProperty(QStringLiteral("kscreenlocker_throttled"), m_throttled);
+    }
+    for (KQuickAddons::QuickViewSharedEngine *view : qAsConst(m_views)) {
+        updateWallpaperVisibility(view);
+    }
+    if (m_throttled) {
+        m_throttledUpdateTimer->start();
+    } else {
+        m_throttledUpdateTimer->stop();
+        flushThrottledUpdates();
+    }
+}
+
+void UnlockApp::updateWallpaperVisibility(KQuickAddons::QuickViewSharedEngine *view)
+{
+    // an animated wallpaper would otherwise keep the views rendering continuously
+    auto object = view->property("wallpaperGraphicsObject").value<KDeclarative::QmlObjectSharedEngine *>();
+    if (!object) {
+        return;
+    }
+    if (auto item = qobject_cast<QQuickItem *>(object->rootObject())) {
+        item->setVisible(!m_throttled);
+    }
+}
+
+void UnlockApp::flushThrottledUpdates()
+{
+    if (m_throttledUpdates.isEmpty()) {
+        return;
+    }
+    const auto views = m_throttledUpdates;
+    m_throttledUpdates.clear();
+    m_flushingThrottledUpdates = true;
+    for (KQuickAddons::QuickViewSharedEngine *view : views) {
+        // the view might have been removed with its screen in the meantime
+        if (m_views.contains(view)) {
+            QEvent updateRequest(QEvent::UpdateRequest);
+            QCoreApplication::sendEvent(view, &updateRequest);
+        }
+    }
+    m_flushingThrottledUpdates = false;
+}
+
+void UnlockApp::activateFromStandby(bool immediateLock, int graceTime, bool noLock, bool switchUser)
+{
+    if (!m_standby) {
+        return;
+    }
+    m_standby = false;
+    qCDebug(KSCREENLOCKER_GREET) << "Greeter got activated from standby.";
+
+    setImmediateLock(immediateLock);
+    setNoLock(noLock);
+    setGraceTime(graceTime);
+    setDefaultToSwitchUser(switchUser);
+
+    for (KQuickAddons::QuickViewSharedEngine *view : qAsConst(m_views)) {
+        view->rootContext()->setContextProperty(QStringLiteral("defaultToSwitchUser"), m_defaultToSwitchUser);
+        QQmlProperty lockProperty(mainItem(view), QStringLiteral("locked"));
+        lockProperty.write(m_immediateLock || (!m_noLock && !m_delayedLockTimer));
+
+        announceView(view);
+        showView(view);
+    }
+
+    // same notification as printed in main for a greeter which is not started in standby
+    std::cout << "Locked at " << QDateTime::currentDateTime().toSecsSinceEpoch() << std::endl;
+}
+
 void UnlockApp::setKsldSocket(int socket)
 {
     using namespace KWayland::Client;
@@ -674,17 +950,62 @@ void UnlockApp::setKsldSocket(int socket)
     EventQueue *queue = new EventQueue(m_ksldRegistry);
 
     connect(m_ksldRegistry, &Registry::interfaceAnnounced, this, [this, queue](QByteArray interface, quint32 name, quint32 version) {
-        Q_UNUSED(version)
         if (interface != QByteArrayLiteral("org_kde_ksld")) {
             return;
         }
-        // bind version 1 as we dropped all the V2 features
-        m_ksldInterface = reinterpret_cast<org_kde_ksld *>(wl_registry_bind(*m_ksldRegistry, name, &org_kde_ksld_interface, 1));
+        // we dropped all the V2 and V3 features, version 4 is needed for the standby activation, 5 for the ready request
+        // and 6 for throttling
+        m_ksldInterface = reinterpret_cast<org_kde_ksld *>(wl_registry_bind(*m_ksldRegistry, name, &org_kde_ksld_interface, qMin(version, 6u)));
         queue->addProxy(m_ksldInterface);
 
-        for (auto v : qAsConst(m_views)) {
-            org_kde_ksld_x11window(m_ksldInterface, v->winId());
-            wl_display_flush(m_ksldConnection->display());
+        static const struct org_kde_ksld_listener s_listener = {
+            .osdProgress =
+                [](void *data, org_kde_ksld *ksld, const char *icon, int32_t percent, const char *text) {
+                    Q_UNUSED(data)
+                    Q_UNUSED(ksld)
+                    Q_UNUSED(icon)
+                    Q_UNUSED(percent)
+                    Q_UNUSED(text)
+                },
+            .osdText =
+                [](void *data, org_kde_ksld *ksld, const char *icon, const char *text) {
+                    Q_UNUSED(data)
+                    Q_UNUSED(ksld)
+                    Q_UNUSED(icon)
+                    Q_UNUSED(text)
+                },
+            .canSuspendSystem =
+                [](void *data, org_kde_ksld *ksld, uint32_t enabled) {
+                    Q_UNUSED(data)
+                    Q_UNUSED(ksld)
+                    Q_UNUSED(enabled)
+                },
+            .canHibernateSystem =
+                [](void *data, org_kde_ksld *ksld, uint32_t enabled) {
+                    Q_UNUSED(data)
+                    Q_UNUSED(ksld)
+                    Q_UNUSED(enabled)
+                },
+            .activate =
+                [](void *data, org_kde_ksld *ksld, uint32_t immediateLock, int32_t graceTime, uint32_t noLock, uint32_t switchUser) {
+                    Q_UNUSED(ksld)
+                    reinterpret_cast<UnlockApp *>(data)->activateFromStandby(immediateLock, graceTime, noLock, switchUser);
+                },
+            .throttle =
+                [](void *data, org_kde_ksld *ksld, uint32_t throttled) {
+                    Q_UNUSED(ksld)
+                    reinterpret_cast<UnlockApp *>(data)->setThrottled(throttled);
+                },
+        };
+        org_kde_ksld_add_listener(m_ksldInterface, &s_listener, this);
+
+        if (!m_standby) {
+            for (auto v : qAsConst(m_views)) {
+                org_kde_ksld_x11window(m_ksldInterface, v->winId());
+                wl_display_flush(m_ksldConnection->display());
+            }
+            // the views might have been on screen before the interface got bound
+            sendReady();
         }
     });
 
@@ -710,7 +1031,7 @@ void UnlockApp::setKsldSocket(int socket)
 void UnlockApp::osdProgress(const QString &icon, int percent, const QString &additionalText)
 {
     for (auto v : qAsConst(m_views)) {
-        auto osd = v->rootObject()->findChild<QQuickItem *>(QStringLiteral("onScreenDisplay"));
+        auto osd = mainItem(v)->findChild<QQuickItem *>(QStringLiteral("onScreenDisplay"));
         if (!osd) {
             continue;
         }
@@ -725,7 +1046,7 @@ void UnlockApp::osdProgress(const QString &icon, int percent, const QString &add
 void UnlockApp::osdText(const QString &icon, const QString &additionalText)
 {
     for (auto v : qAsConst(m_views)) {
-        auto osd = v->rootObject()->findChild<QQuickItem *>(QStringLiteral("onScreenDisplay"));
+        auto osd = mainItem(v)->findChild<QQuickItem *>(QStringLiteral("onScreenDisplay"));
         if (!osd) {
             continue;
         }
@@ -739,7 +1060,7 @@ void UnlockApp::osdText(const QString &icon, const QString &additionalText)
 void UnlockApp::updateCanSuspend()
 {
     for (auto it = m_views.constBegin(), end = m_views.constEnd(); it != end; ++it) {
-        QQmlProperty sleepProperty((*it)->rootObject(), QStringLiteral("suspendToRamSupported"));
+        QQmlProperty sleepProperty(mainItem(*it), QStringLiteral("suspendToRamSupported"));
         sleepProperty.write(PowerManagement::instance()->canSuspend());
     }
 }
@@ -747,7 +1068,7 @@ void UnlockApp::updateCanSuspend()
 void UnlockApp::updateCanHibernate()
 {
     for (auto it = m_views.constBegin(), end = m_views.constEnd(); it != end; ++it) {
-        QQmlProperty hibernateProperty((*it)->rootObject(), QStringLiteral("suspendToDiskSupported"));
+        QQmlProperty hibernateProperty(mainItem(*it), QStringLiteral("suspendToDiskSupported"));
         hibernateProperty.write(PowerManagement::instance()->canHibernate());
     }
 }
@@ -23,6 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KDeclarative/QmlObjectSharedEngine>
 #include <KPackage/PackageStructure>
 #include <QGuiApplication>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
 #include <QUrl>
 
 namespace KWayland
@@ -44,6 +47,9 @@ class Authenticator;
 struct org_kde_ksld;
 
 class PamAuthenticator;
+class QQmlComponent;
+class QQmlEngine;
+class QQuickItem;
 
 namespace ScreenLocker
 {
@@ -58,6 +64,12 @@ public:
     ~UnlockApp() override;
 
     void initialViewSetup();
+    /**
+     * Compiles the configured lock screen without showing anything, which fills the
+     * QML disk cache for the following greeter starts.
+     * @returns @c false if the lock screen QML has errors
+     **/
+    bool warmupQmlCache();
 
     void setTesting(bool enable);
     void setTheme(const QString &theme);
@@ -67,6 +79,18 @@ public:
     void setNoLock(bool noLock);
     void setKsldSocket(int socket);
     void setDefaultToSwitchUser(bool defaultToSwitchUser);
+    void setStandby(bool standby);
+    /**
+     * Shows the views prepared in standby mode. The arguments correspond
+     * to the command line options the greeter would have been started with.
+     **/
+    void activateFromStandby(bool immediateLock, int graceTime, bool noLock, bool switchUser);
+    /**
+     * Hides the wallpaper and caps the frame rate of all views while @p throttled.
+     * Also exposed to the lock screen and wallpaper as kscreenlocker_throttled, which
+     * are expected to reduce their rendering while it is set.
+     **/
+    void setThrottled(bool throttled);
 
     void updateCanSuspend();
     void updateCanHibernate();
@@ -80,6 +104,10 @@ protected:
 
 private Q_SLOTS:
     void handleScreen(QScreen *screen);
+    /**
+     * Creates the view for the next screen that still waits for one.
+     **/
+    void createPendingView();
     KQuickAddons::QuickViewSharedEngine *createViewForScreen(QScreen *screen);
     void resetRequestIgnore();
     void suspendToRam();
@@ -91,14 +119,54 @@ private Q_SLOTS:
 private:
     void initialize();
     void shareEvent(QEvent *e, KQuickAddons::QuickViewSharedEngine *from);
+    void showView(KQuickAddons::QuickViewSharedEngine *view);
+    void announceView(KQuickAddons::QuickViewSharedEngine *view);
+    /**
+     * Tells ksld that the lock screen is on screen once every view presented its first frame.
+     **/
+    void sendReady();
+    /**
+     * Compiles the lock screen QML once for all views. Falls back to the built-in
+     * lock screen if the configured one fails to compile.
+     **/
+    void loadMainComponent(QQmlEngine *engine);
+    void loadFallbackComponent(QQmlEngine *engine);
+    /**
+     * Creates the lock screen of @p view from the main component and puts it into the view.
+     **/
+    QQuickItem *createMainItem(KQuickAddons::QuickViewSharedEngine *view);
+    static QQuickItem *mainItem(KQuickAddons::QuickViewSharedEngine *view);
     KDeclarative::QmlObjectSharedEngine *loadWallpaperPlugin(KQuickAddons::QuickViewSharedEngine *view);
     void setWallpaperItemProperties(KDeclarative::QmlObjectSharedEngine *wallpaperObject, KQuickAddons::QuickViewSharedEngine *view);
+    /**
+     * Shows or hides the wallpaper of @p view depending on whether the greeter is throttled.
+     **/
+    void updateWallpaperVisibility(KQuickAddons::QuickViewSharedEngine *view);
+    /**
+     * Delivers the update requests of the views held back while throttled.
+     **/
+    void flushThrottledUpdates();
     void screenGeometryChanged(QScreen *screen, const QRect &geo);
     QWindow *getActiveScreen();
 
     QString m_packageName;
     QUrl m_mainQmlPath;
+    /**
+     * Keeps the compiled lock screen alive in the engine's type cache, so that every
+     * further view only has to create the objects. Owned by the shared engine.
+     **/
+    QPointer<QQmlComponent> m_mainComponent;
     QList<KQuickAddons::QuickViewSharedEngine *> m_views;
+    /**
+     * Screens whose views get created in later event loop iterations, see initialViewSetup.
+     **/
+    QList<QPointer<QScreen>> m_pendingScreens;
+    QTimer *m_pendingViewsTimer = nullptr;
+    /**
+     * CLOCK_MONOTONIC time in nanoseconds at which each view swapped its first frame.
+     **/
+    QHash<KQuickAddons::QuickViewSharedEngine *, quint64> m_firstFrames;
+    bool m_readySent = false;
     QTimer *m_resetRequestIgnoreTimer;
     QTimer *m_delayedLockTimer;
     KPackage::Package m_package;
@@ -110,6 +178,14 @@ private:
     int m_graceTime;
     bool m_noLock;
     bool m_defaultToSwitchUser;
+    bool m_standby = false;
+    bool m_throttled = false;
+    /**
+     * Releases the update requests held back while throttled once per frame interval.
+     **/
+    QTimer *m_throttledUpdateTimer = nullptr;
+    QSet<KQuickAddons::QuickViewSharedEngine *> m_throttledUpdates;
+    bool m_flushingThrottledUpdates = false;
 
     bool m_canSuspend = false;
     bool m_canHibernate = false;
@@ -140,6 +140,8 @@ int main(int argc, char *argv[])
     QCommandLineOption switchUserOption(QStringLiteral("switchuser"), i18n("Default to the switch user UI."));
 
     QCommandLineOption waylandFdOption(QStringLiteral("ksldfd"), i18n("File descriptor for connecting to ksld."), QStringLiteral("fd"));
+    QCommandLineOption standbyOption(QStringLiteral("standby"), i18n("Prepare the lock user interface, but only show it once ksld requests it."));
+    QCommandLineOption warmupOption(QStringLiteral("warmup"), i18n("Only compile the lock user interface to speed up the next start, then exit."));
 
     parser.addOption(testingOption);
     parser.addOption(themeOption);
@@ -148,8 +150,14 @@ int main(int argc, char *argv[])
     parser.addOption(nolockOption);
     parser.addOption(switchUserOption);
     parser.addOption(waylandFdOption);
+    parser.addOption(standbyOption);
+    parser.addOption(warmupOption);
     parser.process(app);
 
+    if (parser.isSet(warmupOption)) {
+        return app.warmupQmlCache() ? 0 : 1;
+    }
+
     if (parser.isSet(testingOption)) {
         app.setTesting(true);
         app.setImmediateLock(true);
@@ -183,6 +191,9 @@ int main(int argc, char *argv[])
         app.setDefaultToSwitchUser(true);
     }
 
+    const bool standby = parser.isSet(standbyOption) && parser.isSet(waylandFdOption);
+    app.setStandby(standby);
+
     if (parser.isSet(waylandFdOption)) {
         ok = false;
         const int fd = parser.value(waylandFdOption).toInt(&ok);
@@ -195,7 +206,10 @@ int main(int argc, char *argv[])
 
     // This allow ksmserver to know when the application has actually finished setting itself up.
     // Crucial for blocking until it is ready, ensuring locking happens before sleep, e.g.
-    std::cout << "Locked at " << QDateTime::currentDateTime().toSecsSinceEpoch() << std::endl;
+    // A standby greeter reports this once it gets activated.
+    if (!standby) {
+        std::cout << "Locked at " << QDateTime::currentDateTime().toSecsSinceEpoch() << std::endl;
+    }
 
     return app.exec();
 }
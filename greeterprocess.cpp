@@ -0,0 +1,279 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "greeterprocess.h"
+
+#include "kscreenlocker_logging.h"
+
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QVector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
+namespace ScreenLocker
+{
+// milliseconds between checks whether the greeter exited if there is no pidfd
+static const int s_exitPollInterval = 100;
+
+GreeterProcess::GreeterProcess(QObject *parent)
+    : QObject(parent)
+    , m_exitPollTimer(new QTimer(this))
+{
+    m_exitPollTimer->setInterval(s_exitPollInterval);
+    connect(m_exitPollTimer, &QTimer::timeout, this, &GreeterProcess::checkExited);
+}
+
+GreeterProcess::~GreeterProcess()
+{
+    if (m_pid > 0) {
+        ::kill(m_pid, SIGKILL);
+        waitpid(m_pid, nullptr, 0);
+    }
+    cleanUp();
+}
+
+void GreeterProcess::reportFailedToStart()
+{
+    // like QProcess, don't call back into the caller of start
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            Q_EMIT errorOccurred(QProcess::FailedToStart);
+        },
+        Qt::QueuedConnection);
+}
+
+bool GreeterProcess::start(const QString &program, const QStringList &arguments, const QProcessEnvironment &environment)
+{
+    if (m_pid > 0) {
+        qCWarning(KSCREENLOCKER) << "Greeter process is already running";
+        return false;
+    }
+
+    // keep the encoded strings alive till the process got spawned
+    QVector<QByteArray> argumentStorage;
+    argumentStorage << QFile::encodeName(program);
+    for (const QString &argument : arguments) {
+        argumentStorage << argument.toLocal8Bit();
+    }
+    QVector<char *> argv;
+    for (QByteArray &argument : argumentStorage) {
+        argv << argument.data();
+    }
+    argv << nullptr;
+
+    const QStringList environmentList = environment.toStringList();
+    QVector<QByteArray> environmentStorage;
+    for (const QString &variable : environmentList) {
+        environmentStorage << variable.toLocal8Bit();
+    }
+    QVector<char *> envp;
+    for (QByteArray &variable : environmentStorage) {
+        envp << variable.data();
+    }
+    envp << nullptr;
+
+    int stdoutPipe[2];
+    if (pipe2(stdoutPipe, O_CLOEXEC) == -1) {
+        qCWarning(KSCREENLOCKER) << "Could not create pipe for the greeter:" << strerror(errno);
+        reportFailedToStart();
+        return false;
+    }
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_addopen(&fileActions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    // dup2 clears close-on-exec on the target
+    posix_spawn_file_actions_adddup2(&fileActions, stdoutPipe[1], STDOUT_FILENO);
+
+    // don't let the greeter inherit our signal mask or ignored signals
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attributes, &mask);
+    sigset_t defaults;
+    sigfillset(&defaults);
+    posix_spawnattr_setsigdefault(&attributes, &defaults);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    pid_t pid = 0;
+    const int error = posix_spawn(&pid, argv.first(), &fileActions, &attributes, argv.data(), envp.data());
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&fileActions);
+    close(stdoutPipe[1]);
+
+    if (error != 0) {
+        close(stdoutPipe[0]);
+        qCWarning(KSCREENLOCKER) << "Could not start" << program << ":" << strerror(error);
+        reportFailedToStart();
+        return false;
+    }
+
+    m_pid = pid;
+    m_stdout = stdoutPipe[0];
+    fcntl(m_stdout, F_SETFL, fcntl(m_stdout, F_GETFL) | O_NONBLOCK);
+    m_stdoutNotifier = new QSocketNotifier(m_stdout, QSocketNotifier::Read, this);
+    connect(m_stdoutNotifier, &QSocketNotifier::activated, this, &GreeterProcess::readStandardOutput);
+
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_open)
+    m_pidFd = syscall(SYS_pidfd_open, m_pid, 0);
+#endif
+    if (m_pidFd >= 0) {
+        fcntl(m_pidFd, F_SETFD, FD_CLOEXEC);
+        m_exitNotifier = new QSocketNotifier(m_pidFd, QSocketNotifier::Read, this);
+        connect(m_exitNotifier, &QSocketNotifier::activated, this, &GreeterProcess::checkExited);
+    } else {
+        m_exitPollTimer->start();
+    }
+
+    Q_EMIT started();
+    return true;
+}
+
+void GreeterProcess::terminate()
+{
+    if (m_pid > 0) {
+        ::kill(m_pid, SIGTERM);
+    }
+}
+
+void GreeterProcess::kill()
+{
+    if (m_pid > 0) {
+        ::kill(m_pid, SIGKILL);
+    }
+}
+
+QProcess::ProcessState GreeterProcess::state() const
+{
+    return m_pid > 0 ? QProcess::Running : QProcess::NotRunning;
+}
+
+qint64 GreeterProcess::processId() const
+{
+    return m_pid;
+}
+
+bool GreeterProcess::canReadLine() const
+{
+    return m_stdoutBuffer.contains('\n');
+}
+
+QByteArray GreeterProcess::readLine()
+{
+    const int index = m_stdoutBuffer.indexOf('\n');
+    const QByteArray line = index == -1 ? m_stdoutBuffer : m_stdoutBuffer.left(index + 1);
+    m_stdoutBuffer.remove(0, line.size());
+    return line;
+}
+
+void GreeterProcess::readStandardOutput()
+{
+    if (!m_stdoutNotifier || !m_stdoutNotifier->isEnabled()) {
+        return;
+    }
+    bool gotData = false;
+    bool endOfFile = false;
+    char buffer[512];
+    while (true) {
+        const ssize_t count = read(m_stdout, buffer, sizeof(buffer));
+        if (count > 0) {
+            m_stdoutBuffer.append(buffer, count);
+            gotData = true;
+        } else if (count == 0) {
+            endOfFile = true;
+            break;
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+    if (endOfFile) {
+        m_stdoutNotifier->setEnabled(false);
+    }
+    if (gotData) {
+        Q_EMIT readyReadStandardOutput();
+    }
+    if (endOfFile && m_pidFd < 0) {
+        // most likely the greeter is exiting, no need to wait for the next poll
+        checkExited();
+    }
+}
+
+void GreeterProcess::checkExited()
+{
+    if (m_pid <= 0) {
+        return;
+    }
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(m_pid, &status, WNOHANG);
+    } while (result == -1 && errno == EINTR);
+    if (result == 0) {
+        // still running
+        return;
+    }
+
+    // whatever the greeter wrote before exiting
+    readStandardOutput();
+    m_pid = 0;
+    cleanUp();
+
+    if (result == -1) {
+        qCWarning(KSCREENLOCKER) << "Greeter process got reaped by someone else:" << strerror(errno);
+        Q_EMIT errorOccurred(QProcess::Crashed);
+        Q_EMIT finished(-1, QProcess::CrashExit);
+    } else if (WIFEXITED(status)) {
+        Q_EMIT finished(WEXITSTATUS(status), QProcess::NormalExit);
+    } else {
+        Q_EMIT errorOccurred(QProcess::Crashed);
+        Q_EMIT finished(WIFSIGNALED(status) ? WTERMSIG(status) : -1, QProcess::CrashExit);
+    }
+}
+
+void GreeterProcess::cleanUp()
+{
+    m_exitPollTimer->stop();
+    delete m_stdoutNotifier;
+    m_stdoutNotifier = nullptr;
+    delete m_exitNotifier;
+    m_exitNotifier = nullptr;
+    if (m_stdout >= 0) {
+        close(m_stdout);
+        m_stdout = -1;
+    }
+    if (m_pidFd >= 0) {
+        close(m_pidFd);
+        m_pidFd = -1;
+    }
+    m_stdoutBuffer.clear();
+}
+
+}
@@ -0,0 +1,89 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef SCREENLOCKER_GREETERPROCESS_H
+#define SCREENLOCKER_GREETERPROCESS_H
+
+#include <QObject>
+#include <QProcess>
+
+#include <sys/types.h>
+
+class QSocketNotifier;
+class QTimer;
+
+namespace ScreenLocker
+{
+/**
+ * Runs the greeter as a child process.
+ *
+ * ksld is part of a large process, forking it to start the greeter like QProcess does means
+ * copying the page tables of the whole address space. This class uses posix_spawn instead,
+ * which does not need to duplicate the address space.
+ *
+ * The interface follows QProcess: standard output can be read line by line, standard error
+ * is forwarded and all file descriptors without close-on-exec are inherited by the greeter.
+ **/
+class GreeterProcess : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GreeterProcess(QObject *parent = nullptr);
+    ~GreeterProcess() override;
+
+    /**
+     * Starts @p program. Emits started on success, otherwise returns @c false and
+     * emits errorOccurred with QProcess::FailedToStart from the event loop.
+     **/
+    bool start(const QString &program, const QStringList &arguments, const QProcessEnvironment &environment);
+    void terminate();
+    void kill();
+
+    QProcess::ProcessState state() const;
+    qint64 processId() const;
+
+    bool canReadLine() const;
+    QByteArray readLine();
+
+Q_SIGNALS:
+    void started();
+    void finished(int exitCode, QProcess::ExitStatus exitStatus);
+    void errorOccurred(QProcess::ProcessError error);
+    void readyReadStandardOutput();
+
+private:
+    void reportFailedToStart();
+    void readStandardOutput();
+    void checkExited();
+    void cleanUp();
+
+    pid_t m_pid = 0;
+    int m_stdout = -1;
+    /**
+     * Becomes readable once the child exited. Only available on Linux, elsewhere
+     * the child gets polled for.
+     **/
+    int m_pidFd = -1;
+    QSocketNotifier *m_stdoutNotifier = nullptr;
+    QSocketNotifier *m_exitNotifier = nullptr;
+    QTimer *m_exitPollTimer;
+    QByteArray m_stdoutBuffer;
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "inhibitregistry.h"
+
+namespace ScreenLocker
+{
+InhibitRegistry::InhibitRegistry(uint firstCookie)
+    : m_nextCookie(firstCookie)
+{
+}
+
+uint InhibitRegistry::add(const QString &sender)
+{
+    // skip cookies still in use after wrapping around
+    while (m_entries.contains(m_nextCookie)) {
+        ++m_nextCookie;
+    }
+    const uint cookie = m_nextCookie++;
+    m_entries.insert(cookie, Entry{sender, 0});
+    m_cookiesBySender[sender].insert(cookie);
+    return cookie;
+}
+
+bool InhibitRegistry::setForwardedCookie(uint cookie, uint forwardedCookie)
+{
+    auto it = m_entries.find(cookie);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    it->forwardedCookie = forwardedCookie;
+    return true;
+}
+
+bool InhibitRegistry::remove(uint cookie, Entry *removed)
+{
+    auto it = m_entries.find(cookie);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    auto senderIt = m_cookiesBySender.find(it->sender);
+    if (senderIt != m_cookiesBySender.end()) {
+        senderIt->remove(cookie);
+        if (senderIt->isEmpty()) {
+            m_cookiesBySender.erase(senderIt);
+        }
+    }
+    if (removed) {
+        *removed = it.value();
+    }
+    m_entries.erase(it);
+    return true;
+}
+
+QVector<InhibitRegistry::Entry> InhibitRegistry::removeSender(const QString &sender)
+{
+    QVector<Entry> removed;
+    auto senderIt = m_cookiesBySender.find(sender);
+    if (senderIt == m_cookiesBySender.end()) {
+        return removed;
+    }
+    removed.reserve(senderIt->size());
+    for (uint cookie : qAsConst(*senderIt)) {
+        auto it = m_entries.find(cookie);
+        if (it != m_entries.end()) {
+            removed << it.value();
+            m_entries.erase(it);
+        }
+    }
+    m_cookiesBySender.erase(senderIt);
+    return removed;
+}
+
+bool InhibitRegistry::contains(uint cookie) const
+{
+    return m_entries.contains(cookie);
+}
+
+bool InhibitRegistry::hasSender(const QString &sender) const
+{
+    return m_cookiesBySender.contains(sender);
+}
+
+int InhibitRegistry::count() const
+{
+    return m_entries.size();
+}
+
+int InhibitRegistry::count(const QString &sender) const
+{
+    return m_cookiesBySender.value(sender).size();
+}
+
+bool InhibitRegistry::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+}
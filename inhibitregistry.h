@@ -0,0 +1,84 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef SCREENLOCKER_INHIBITREGISTRY_H
+#define SCREENLOCKER_INHIBITREGISTRY_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+namespace ScreenLocker
+{
+/**
+ * Keeps track of the cookies handed out to DBus clients, e.g. for Inhibit.
+ *
+ * The cookies are indexed both by their value and by the DBus service of the client, so that
+ * releasing a single cookie and releasing all cookies of a vanished client do not depend on
+ * the number of cookies held by other clients.
+ **/
+class InhibitRegistry
+{
+public:
+    struct Entry {
+        QString sender;
+        /**
+         * The cookie the request got forwarded with, e.g. to PowerDevil. 0 if not (yet) known.
+         **/
+        uint forwardedCookie = 0;
+    };
+
+    /**
+     * @param firstCookie the cookie handed out first, following ones are counted up from it
+     **/
+    explicit InhibitRegistry(uint firstCookie = 0);
+
+    /**
+     * Registers a request of @p sender and returns its cookie.
+     **/
+    uint add(const QString &sender);
+    /**
+     * @returns @c false if @p cookie is not known, e.g. because it got removed meanwhile
+     **/
+    bool setForwardedCookie(uint cookie, uint forwardedCookie);
+    /**
+     * Removes @p cookie and stores what it was registered with in @p removed.
+     * @returns @c false if @p cookie is not known
+     **/
+    bool remove(uint cookie, Entry *removed = nullptr);
+    /**
+     * Removes all requests of @p sender at once.
+     * @returns the removed requests
+     **/
+    QVector<Entry> removeSender(const QString &sender);
+
+    bool contains(uint cookie) const;
+    bool hasSender(const QString &sender) const;
+    int count() const;
+    int count(const QString &sender) const;
+    bool isEmpty() const;
+
+private:
+    QHash<uint, Entry> m_entries;
+    QHash<QString, QSet<uint>> m_cookiesBySender;
+    uint m_nextCookie;
+};
+
+}
+
+#endif
@@ -28,7 +28,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KIdleTime>
 // Qt
 #include <QDBusConnection>
-#include <QDBusReply>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusServiceWatcher>
 #include <QRandomGenerator>
 
@@ -40,7 +41,15 @@ Interface::Interface(KSldApp *parent)
     : QObject(parent)
     , m_daemon(parent)
     , m_serviceWatcher(new QDBusServiceWatcher(this))
-    , m_next_cookie(0)
+    , m_policyAgent(new OrgKdeSolidPowerManagementPolicyAgentInterface(QStringLiteral("org.kde.Solid.PowerManagement.PolicyAgent"),
+                                                                       QStringLiteral("/org/kde/Solid/PowerManagement/PolicyAgent"),
+                                                                       QDBusConnection::sessionBus(),
+                                                                       this))
+    // I make it a really random number to avoid
+    // some assumptions in clients, but just increase
+    // while gnome-ss creates a random number every time
+    , m_inhibitions(QRandomGenerator::global()->bounded(19999))
+    , m_throttles(QRandomGenerator::global()->bounded(19999))
 {
     (void)new ScreenSaverAdaptor(this);
     QDBusConnection::sessionBus().registerService(QStringLiteral("org.freedesktop.ScreenSaver"));
@@ -55,11 +64,6 @@ Interface::Interface(KSldApp *parent)
     m_serviceWatcher->setConnection(QDBusConnection::sessionBus());
     m_serviceWatcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
     connect(m_serviceWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &Interface::serviceUnregistered);
-
-    // I make it a really random number to avoid
-    // some assumptions in clients, but just increase
-    // while gnome-ss creates a random number every time
-    m_next_cookie = QRandomGenerator::global()->bounded(19999);
 }
 
 Interface::~Interface()
@@ -120,47 +124,66 @@ bool Interface::SetActive(bool state)
 
 uint Interface::Inhibit(const QString &application_name, const QString &reason_for_inhibit)
 {
-    OrgKdeSolidPowerManagementPolicyAgentInterface policyAgent(QStringLiteral("org.kde.Solid.PowerManagement.PolicyAgent"),
-                                                               QStringLiteral("/org/kde/Solid/PowerManagement/PolicyAgent"),
-                                                               QDBusConnection::sessionBus());
-    QDBusReply<uint> reply = policyAgent.AddInhibition(ChangeScreenSettings, application_name, reason_for_inhibit);
-
-    InhibitRequest sr;
-    sr.cookie = m_next_cookie++;
-    sr.dbusid = message().service();
-    sr.powerdevilcookie = reply.isValid() ? reply : 0;
-    m_requests.append(sr);
-    m_serviceWatcher->addWatchedService(sr.dbusid);
+    const QString sender = message().service();
+    const uint cookie = m_inhibitions.add(sender);
+    m_serviceWatcher->addWatchedService(sender);
     KSldApp::self()->inhibit();
-    return sr.cookie;
+
+    // our cookie does not depend on PowerDevil, so don't wait for it
+    QDBusPendingCallWatcher *callWatcher =
+        new QDBusPendingCallWatcher(m_policyAgent->AddInhibition(ChangeScreenSettings, application_name, reason_for_inhibit), this);
+    connect(callWatcher, &QDBusPendingCallWatcher::finished, this, [this, cookie](QDBusPendingCallWatcher *self) {
+        QDBusPendingReply<uint> reply = *self;
+        self->deleteLater();
+        if (!reply.isValid() || reply.value() == 0) {
+            return;
+        }
+        if (!m_inhibitions.setForwardedCookie(cookie, reply.value())) {
+            // released before PowerDevil replied
+            m_policyAgent->ReleaseInhibition(reply.value());
+        }
+    });
+    return cookie;
 }
 
 void Interface::UnInhibit(uint cookie)
 {
-    QMutableListIterator<InhibitRequest> it(m_requests);
-    while (it.hasNext()) {
-        if (it.next().cookie == cookie) {
-            if (uint powerdevilcookie = it.value().powerdevilcookie) {
-                OrgKdeSolidPowerManagementPolicyAgentInterface policyAgent(QStringLiteral("org.kde.Solid.PowerManagement.PolicyAgent"),
-                                                                           QStringLiteral("/org/kde/Solid/PowerManagement/PolicyAgent"),
-                                                                           QDBusConnection::sessionBus());
-                policyAgent.ReleaseInhibition(powerdevilcookie);
-            }
-            it.remove();
-            KSldApp::self()->uninhibit();
-            break;
-        }
+    InhibitRegistry::Entry inhibition;
+    if (!m_inhibitions.remove(cookie, &inhibition)) {
+        return;
     }
+    if (inhibition.forwardedCookie) {
+        m_policyAgent->ReleaseInhibition(inhibition.forwardedCookie);
+    }
+    unwatchIfUnused(inhibition.sender);
+    KSldApp::self()->uninhibit();
 }
 
 void Interface::serviceUnregistered(const QString &name)
 {
     m_serviceWatcher->removeWatchedService(name);
-    QListIterator<InhibitRequest> it(m_requests);
-    while (it.hasNext()) {
-        const InhibitRequest &r = it.next();
-        if (r.dbusid == name) {
-            UnInhibit(r.cookie);
+    const QVector<InhibitRegistry::Entry> inhibitions = m_inhibitions.removeSender(name);
+    releasePowerDevilInhibitions(inhibitions);
+    for (int i = 0; i < inhibitions.size(); ++i) {
+        KSldApp::self()->uninhibit();
+    }
+    if (!m_throttles.removeSender(name).isEmpty() && m_throttles.isEmpty()) {
+        m_daemon->setThrottled(false);
+    }
+}
+
+void Interface::unwatchIfUnused(const QString &sender)
+{
+    if (!m_inhibitions.hasSender(sender) && !m_throttles.hasSender(sender)) {
+        m_serviceWatcher->removeWatchedService(sender);
+    }
+}
+
+void Interface::releasePowerDevilInhibitions(const QVector<InhibitRegistry::Entry> &inhibitions)
+{
+    for (const InhibitRegistry::Entry &inhibition : inhibitions) {
+        if (inhibition.forwardedCookie) {
+            m_policyAgent->ReleaseInhibition(inhibition.forwardedCookie);
         }
     }
 }
@@ -174,14 +197,25 @@ uint Interface::Throttle(const QString &application_name, const QString &reason_
 {
     Q_UNUSED(application_name)
     Q_UNUSED(reason_for_inhibit)
-    // TODO: implement me
-    return 0;
+    const QString sender = message().service();
+    const uint cookie = m_throttles.add(sender);
+    m_serviceWatcher->addWatchedService(sender);
+    if (m_throttles.count() == 1) {
+        m_daemon->setThrottled(true);
+    }
+    return cookie;
 }
 
 void Interface::UnThrottle(uint cookie)
 {
-    Q_UNUSED(cookie)
-    // TODO: implement me
+    InhibitRegistry::Entry throttle;
+    if (!m_throttles.remove(cookie, &throttle)) {
+        return;
+    }
+    unwatchIfUnused(throttle.sender);
+    if (m_throttles.isEmpty()) {
+        m_daemon->setThrottled(false);
+    }
 }
 
 void Interface::slotLocked()
@@ -196,6 +230,11 @@ void Interface::slotUnlocked()
     Q_EMIT ActiveChanged(false);
 }
 
+QVariantMap Interface::GetLockLatency()
+{
+    return m_daemon->lockLatency();
+}
+
 void Interface::configure()
 {
     m_daemon->configure();
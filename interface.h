@@ -21,22 +21,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SCREENLOCKER_INTERFACE_H
 #define SCREENLOCKER_INTERFACE_H
 
+#include "inhibitregistry.h"
+
 #include <QDBusContext>
 #include <QDBusMessage>
 #include <QObject>
 
 class QDBusServiceWatcher;
+class OrgKdeSolidPowerManagementPolicyAgentInterface;
 
 namespace ScreenLocker
 {
-class InhibitRequest
-{
-public:
-    QString dbusid;
-    uint cookie;
-    uint powerdevilcookie;
-};
-
 class KSldApp;
 class Interface : public QObject, protected QDBusContext
 {
@@ -107,6 +102,7 @@ public Q_SLOTS:
 
     // org.kde.screensvar
     void configure();
+    QVariantMap GetLockLatency();
 
 Q_SIGNALS:
     // DBus signals
@@ -121,11 +117,23 @@ private Q_SLOTS:
 
 private:
     void sendLockReplies();
+    /**
+     * Releases the PowerDevil inhibitions of @p inhibitions, without waiting for replies.
+     **/
+    void releasePowerDevilInhibitions(const QVector<InhibitRegistry::Entry> &inhibitions);
+    /**
+     * Stops watching @p sender once it holds neither inhibitions nor throttles.
+     **/
+    void unwatchIfUnused(const QString &sender);
 
     KSldApp *m_daemon;
     QDBusServiceWatcher *m_serviceWatcher;
-    QList<InhibitRequest> m_requests;
-    uint m_next_cookie;
+    OrgKdeSolidPowerManagementPolicyAgentInterface *m_policyAgent;
+    /**
+     * The forwarded cookie is the one from PowerDevil, 0 till PowerDevil replied.
+     **/
+    InhibitRegistry m_inhibitions;
+    InhibitRegistry m_throttles;
     QList<QDBusMessage> m_lockReplies;
 };
 }
@@ -26,14 +26,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "screenlocker_interface.h"
 
 #include <KAboutData>
+#include <KConfigGroup>
 #include <KConfigLoader>
 #include <KConfigPropertyMap>
 #include <KGlobalAccel>
+#include <KLibexec>
 #include <KLocalizedString>
 #include <KPluginFactory>
+#include <KSharedConfig>
 
 #include <KPackage/PackageLoader>
 
+#include <QProcess>
 #include <QVector>
 
 K_PLUGIN_FACTORY_WITH_JSON(ScreenLockerKcmFactory, "kcm_screenlocker.json", registerPlugin<ScreenLockerKcm>(); registerPlugin<KScreenLockerData>();)
@@ -67,6 +71,7 @@ void ScreenLockerKcm::load()
 {
     ManagedConfigModule::load();
     m_appearanceSettings->load();
+    m_lockScreenPackage = lockScreenPackage();
 
     updateState();
 }
@@ -81,6 +86,12 @@ void ScreenLockerKcm::save()
     if (interface.isValid()) {
         interface.configure();
     }
+    // the lock screen changed, compile it now so that locking does not have to wait for it
+    const QString package = lockScreenPackage();
+    if (package != m_lockScreenPackage) {
+        m_lockScreenPackage = package;
+        QProcess::startDetached(KLibexec::path(QStringLiteral(KSCREENLOCKER_GREET_BIN_REL)), {QStringLiteral("--warmup")});
+    }
     updateState();
 }
 
@@ -126,6 +137,17 @@ KConfigPropertyMap *ScreenLockerKcm::lnfConfiguration() const
     return m_appearanceSettings->lnfConfiguration();
 }
 
+QString ScreenLockerKcm::lockScreenPackage() const
+{
+    // same lookup as the greeter: the configured theme overrides the look and feel package
+    const QString theme = KScreenSaverSettings::getInstance().theme();
+    if (!theme.isEmpty()) {
+        return theme;
+    }
+    KConfigGroup cg(KSharedConfig::openConfig(QStringLiteral("kdeglobals")), "KDE");
+    return cg.readEntry("LookAndFeelPackage", QString());
+}
+
 KScreenSaverSettings *ScreenLockerKcm::settings() const
 {
     return &KScreenSaverSettings::getInstance();
@@ -80,9 +80,11 @@ private:
 
     KConfigPropertyMap *wallpaperConfiguration() const;
     KConfigPropertyMap *lnfConfiguration() const;
+    QString lockScreenPackage() const;
 
     AppearanceSettings *m_appearanceSettings;
     QString m_currentWallpaper;
+    QString m_lockScreenPackage;
     bool m_forceUpdateState = false;
 };
 
@@ -22,8 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "ksldapp.h"
 #include "globalaccel.h"
+#include "greeterprocess.h"
 #include "interface.h"
 #include "kscreensaversettings.h"
+#include "locklatency.h"
 #include "logind.h"
 #include "powermanagement_inhibition.h"
 #include "waylandlocker.h"
@@ -47,7 +49,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFile>
 #include <QKeyEvent>
 #include <QProcess>
+#include <QScopedPointer>
 #include <QTimer>
+#include <QVector>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <private/qtx11extras_p.h>
 #else
@@ -58,8 +62,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xcb/xcb.h>
 #if X11_Xinput_FOUND
 #include <X11/extensions/XInput2.h>
+#include <xcb/xinput.h>
 #endif
 // other
+#include <algorithm>
 #include <signal.h>
 #include <unistd.h>
 
@@ -69,6 +75,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace ScreenLocker
 {
 static const QString s_qtQuickBackend = QStringLiteral("QT_QUICK_BACKEND");
+// milliseconds the greeter gets after resume to finish a lock started for suspend
+static const int s_suspendLockDeadline = 10000;
+// milliseconds after which the screen counts as locked even if the greeter did not report being ready
+static const int s_greeterReadyDeadline = 10000;
 
 static KSldApp *s_instance = nullptr;
 
@@ -92,18 +102,19 @@ KSldApp::KSldApp(QObject *parent)
     , m_lockGrace(0)
     , m_inGraceTime(false)
     , m_graceTimer(new QTimer(this))
+    , m_suspendLockDeadline(new QTimer(this))
+    , m_greeterReadyDeadline(new QTimer(this))
     , m_inhibitCounter(0)
     , m_logind(nullptr)
     , m_greeterEnv(QProcessEnvironment::systemEnvironment())
     , m_powerManagementInhibition(new PowerManagementInhibition(this))
+    , m_lockLatency(new LockLatencyTracker)
 {
     m_isX11 = QX11Info::isPlatformX11();
     m_isWayland = QCoreApplication::instance()->property("platformName").toString().startsWith(QLatin1String("wayland"), Qt::CaseInsensitive);
 }
 
-KSldApp::~KSldApp()
-{
-}
+KSldApp::~KSldApp() = default;
 
 static int s_XTimeout;
 static int s_XInterval;
@@ -153,6 +164,12 @@ static bool hasXInput()
 void KSldApp::initializeX11()
 {
     m_hasXInput2 = hasXInput();
+#if X11_Xinput_FOUND
+    if (m_hasXInput2) {
+        // avoid a round trip for the extension's opcode when the screen gets locked
+        xcb_prefetch_extension_data(QX11Info::connection(), &xcb_input_id);
+    }
+#endif
     // Save X screensaver parameters
     XGetScreenSaver(QX11Info::display(), &s_XTimeout, &s_XInterval, &s_XBlanking, &s_XExposures);
     // And disable it. The internal X screensaver is not used at all, but we use its
@@ -206,16 +223,29 @@ void KSldApp::initialize()
         lock(EstablishLock::Delayed);
     });
 
-    m_lockProcess = new QProcess();
-    m_lockProcess->setProcessChannelMode(QProcess::ForwardedErrorChannel);
-    m_lockProcess->setReadChannel(QProcess::StandardOutput);
-    auto finishedSignal = static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished);
-    connect(m_lockProcess, finishedSignal, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+    m_lockProcess = new GreeterProcess();
+    connect(m_lockProcess, &GreeterProcess::finished, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
         qCDebug(KSCREENLOCKER) << "Greeter process exitted with status:" << exitStatus << "exit code:" << exitCode;
 
+        if (m_greeterInStandby) {
+            // the prepared greeter went away before it got used, the next lock starts a new one
+            m_greeterInStandby = false;
+            m_waylandServer->stop();
+            if (m_greeterStandbyStopping) {
+                m_greeterStandbyStopping = false;
+                // starts a new one if standby is still enabled
+                startStandbyGreeter();
+            } else {
+                qCWarning(KSCREENLOCKER) << "Standby greeter exited unexpectedly.";
+            }
+            return;
+        }
+
         const bool regularExit = !exitCode && exitStatus == QProcess::NormalExit;
         if (regularExit || s_graceTimeKill || s_logindExit) {
             // unlock process finished successfully - we can remove the lock grab
+            m_lockLatency->startUnlock();
+            m_lockLatency->mark(LockLatencyTracker::Phase::GreeterExited);
 
             if (regularExit) {
                 qCDebug(KSCREENLOCKER) << "Unlocking now on regular exit.";
@@ -243,11 +273,35 @@ void KSldApp::initialize()
         } else if (m_lockWindow) {
             qCWarning(KSCREENLOCKER) << "Everything else failed. Need to put Greeter in emergency mode.";
             m_lockWindow->emergencyShow();
+            // no greeter is going to report being ready, the emergency window is what locks the screen
+            lockScreenShown();
         } else {
             qCCritical(KSCREENLOCKER) << "Greeter process exitted and we could in no way recover from that!";
         }
     });
-    connect(m_lockProcess, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+    connect(m_lockProcess, &GreeterProcess::started, this, [this]() {
+        m_lockLatency->mark(LockLatencyTracker::Phase::GreeterStarted);
+    });
+    connect(m_lockProcess, &GreeterProcess::readyReadStandardOutput, this, [this]() {
+        while (m_lockProcess->canReadLine()) {
+            const QByteArray line = m_lockProcess->readLine();
+            if (line.startsWith("Locked at ")) {
+                m_lockLatency->mark(LockLatencyTracker::Phase::GreeterLocked);
+            }
+        }
+    });
+    connect(m_lockProcess, &GreeterProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart && m_lockProcess->state() != QProcess::NotRunning) {
+            // reported from the event loop after a later attempt already succeeded
+            return;
+        }
+        // only the standby greeter gets started while unlocked
+        if (error == QProcess::FailedToStart && (m_greeterInStandby || m_lockState == Unlocked)) {
+            qCWarning(KSCREENLOCKER) << "Standby greeter failed to start.";
+            m_greeterInStandby = false;
+            m_waylandServer->stop();
+            return;
+        }
         if (error == QProcess::FailedToStart) {
             qCDebug(KSCREENLOCKER) << "Greeter Process  failed to start. Trying to directly unlock again.";
             doUnlock();
@@ -257,6 +311,13 @@ void KSldApp::initialize()
             qCWarning(KSCREENLOCKER) << "Greeter Process encountered an unhandled error:" << error;
         }
     });
+    connect(m_waylandServer, &WaylandServer::greeterReady, this, [this](const QVector<quint64> &firstFrames) {
+        if (!firstFrames.isEmpty()) {
+            m_lockLatency->markAt(LockLatencyTracker::Phase::FirstFrame, *std::max_element(firstFrames.constBegin(), firstFrames.constEnd()));
+        }
+        m_lockLatency->mark(LockLatencyTracker::Phase::GreeterReady);
+        lockScreenShown();
+    });
     m_lockedTimer.invalidate();
     m_graceTimer->setSingleShot(true);
     connect(m_graceTimer, &QTimer::timeout, this, &KSldApp::endGraceTime);
@@ -271,6 +332,7 @@ void KSldApp::initialize()
     connect(m_logind, &LogindIntegration::requestUnlock, this, [this]() {
         if (lockState() == Locked || lockState() == AcquiringLock) {
             if (m_lockProcess->state() != QProcess::NotRunning) {
+                m_lockLatency->startUnlock();
                 s_logindExit = true;
                 m_lockProcess->terminate();
             } else {
@@ -280,13 +342,43 @@ void KSldApp::initialize()
     });
     connect(m_logind, &LogindIntegration::prepareForSleep, this, [this](bool goingToSleep) {
         if (!goingToSleep) {
-            // not interested in doing anything on wakeup
+            if (m_suspendLock && m_lockState == AcquiringLock) {
+                // the greeter got interrupted by the suspend, give it a limited time to finish
+                m_suspendLockDeadline->start();
+            }
             return;
         }
         if (KScreenSaverSettings::lockOnResume()) {
+            // on X11 the black background is enough to go to sleep, the greeter can finish after resume
+            m_suspendLock = m_isX11 && m_lockState == Unlocked;
             lock(EstablishLock::Immediate);
         }
     });
+    m_suspendLockDeadline->setSingleShot(true);
+    m_suspendLockDeadline->setInterval(s_suspendLockDeadline);
+    connect(m_suspendLockDeadline, &QTimer::timeout, this, [this]() {
+        if (m_lockState != AcquiringLock) {
+            return;
+        }
+        qCWarning(KSCREENLOCKER) << "Greeter did not come up after resume, restarting it.";
+        if (m_lockProcess->state() != QProcess::NotRunning) {
+            // the regular crash handling restarts the greeter or falls back to the emergency mode
+            m_lockProcess->terminate();
+        } else if (m_lockWindow) {
+            m_lockWindow->emergencyShow();
+            lockScreenShown();
+        }
+    });
+    m_greeterReadyDeadline->setSingleShot(true);
+    m_greeterReadyDeadline->setInterval(s_greeterReadyDeadline);
+    connect(m_greeterReadyDeadline, &QTimer::timeout, this, [this]() {
+        if (m_lockState != AcquiringLock) {
+            return;
+        }
+        // the lock window and the grabs are in place, only the greeter's report is missing
+        qCWarning(KSCREENLOCKER) << "Greeter did not report being ready, considering the screen locked anyway.";
+        lockScreenShown();
+    });
     connect(m_logind, &LogindIntegration::inhibited, this, [this]() {
         // if we are already locked, we immediately remove the inhibition lock
         if (m_lockState == KSldApp::Locked) {
@@ -305,6 +397,9 @@ void KSldApp::initialize()
         }
     });
     connect(this, &KSldApp::locked, this, [this]() {
+        m_suspendLock = false;
+        m_suspendLockDeadline->stop();
+        m_greeterReadyDeadline->stop();
         m_logind->uninhibit();
         m_logind->setLocked(true);
         if (m_lockGrace > 0 && m_inGraceTime) {
@@ -320,7 +415,13 @@ void KSldApp::initialize()
 
     m_globalAccel = new GlobalAccel(this);
     connect(this, &KSldApp::locked, m_globalAccel, &GlobalAccel::prepare);
-    connect(this, &KSldApp::unlocked, m_globalAccel, &GlobalAccel::release);
+    // cached for the whole session, so that the shortcuts work right from the start of the lock
+    m_globalAccel->prepare();
+
+    if (m_isX11) {
+        // discover the toplevel windows once, so that locking does not need to
+        createLockWindow();
+    }
 
     // fallback for non-logind systems:
     // connect to signal emitted by Solid. This is emitted unconditionally also on logind enabled systems
@@ -370,6 +471,45 @@ void KSldApp::configure()
             m_logind->uninhibit();
         }
     }
+    // the greeter gets its environment from kwin on Wayland only once the screen is about to lock,
+    // so a standby greeter is only possible on X11
+    m_greeterStandbyEnabled = KScreenSaverSettings::greeterStandby() && m_isX11;
+    if (m_lockProcess) {
+        // a running standby greeter might use an outdated configuration
+        restartStandbyGreeter();
+    }
+    if (m_isX11 && m_lockWindow) {
+        // takes effect with the next lock
+        static_cast<X11Locker *>(m_lockWindow)->setUseCompositeOverlay(KScreenSaverSettings::x11CompositeOverlay());
+    }
+}
+
+void KSldApp::setGreeterStandbyEnabled(bool enabled)
+{
+    m_greeterStandbyEnabled = enabled && m_isX11;
+    restartStandbyGreeter();
+}
+
+void KSldApp::startStandbyGreeter()
+{
+    if (!m_greeterStandbyEnabled || m_lockState != Unlocked || !m_lockProcess || m_lockProcess->state() != QProcess::NotRunning) {
+        return;
+    }
+    qCDebug(KSCREENLOCKER) << "Starting greeter in standby mode";
+    m_greeterInStandby = true;
+    if (!launchGreeter(m_greeterEnv, {QStringLiteral("--standby")})) {
+        m_greeterInStandby = false;
+    }
+}
+
+void KSldApp::restartStandbyGreeter()
+{
+    if (m_greeterInStandby && m_lockProcess && m_lockProcess->state() != QProcess::NotRunning) {
+        m_greeterStandbyStopping = true;
+        m_lockProcess->terminate();
+        return;
+    }
+    startStandbyGreeter();
 }
 
 void KSldApp::lock(EstablishLock establishLock, int attemptCount)
@@ -386,26 +526,36 @@ void KSldApp::lock(EstablishLock establishLock, int attemptCount)
     }
 
     if (attemptCount == 0) {
+        m_lockLatency->startLock();
         Q_EMIT aboutToLock();
     }
 
     qCDebug(KSCREENLOCKER) << "lock called";
     if (!establishGrab()) {
-        if (attemptCount < 3) {
-            qCWarning(KSCREENLOCKER) << "Could not establish screen lock. Trying again in 10ms";
-            QTimer::singleShot(10, this, [=]() {
+        if (attemptCount < 5) {
+            // the client holding a grab usually releases it quickly, so retry soon and back off exponentially
+            const int delay = 1 << attemptCount;
+            qCWarning(KSCREENLOCKER) << "Could not establish screen lock. Trying again in" << delay << "ms";
+            QTimer::singleShot(delay, this, [=]() {
                 lock(establishLock, attemptCount + 1);
             });
         } else {
             qCCritical(KSCREENLOCKER) << "Could not establish screen lock";
+            m_suspendLock = false;
         }
         return;
     }
+    m_lockLatency->mark(LockLatencyTracker::Phase::GrabEstablished);
 
     KNotification::event(QStringLiteral("locked"), i18n("Screen locked"), QPixmap(), nullptr, KNotification::CloseOnTimeout, QStringLiteral("ksmserver"));
 
     // blank the screen
     showLockWindow();
+    if (m_suspendLock && !(m_lockWindow && m_lockWindow->showBackground())) {
+        // the sleep inhibitor is kept till the greeter is ready
+        m_suspendLock = false;
+    }
+    m_lockLatency->mark(LockLatencyTracker::Phase::LockWindowShown);
 
     m_lockState = AcquiringLock;
 
@@ -415,13 +565,6 @@ void KSldApp::lock(EstablishLock establishLock, int attemptCount)
     Q_EMIT lockStateChanged();
 }
 
-/*
- * Forward declarations:
- * Only called from KSldApp::establishGrab(). Using from somewhere else is incorrect usage!
- **/
-static bool grabKeyboard();
-static bool grabMouse();
-
 class XServerGrabber
 {
 public:
@@ -444,68 +587,90 @@ bool KSldApp::establishGrab()
     if (!m_isX11) {
         return true;
     }
-    XSync(QX11Info::display(), False);
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_window_t root = QX11Info::appRootWindow();
     XServerGrabber serverGrabber;
-    if (!grabKeyboard()) {
-        return false;
+
+    // all requests get sent before waiting for the first reply, so that establishing
+    // the grab only costs two round trips independent of the number of devices
+    const uint16_t pointerEvents = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_ENTER_WINDOW
+        | XCB_EVENT_MASK_LEAVE_WINDOW;
+    const auto keyboardCookie = xcb_grab_keyboard(c, true, root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+    const auto pointerCookie =
+        xcb_grab_pointer(c, true, root, pointerEvents, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, XCB_WINDOW_NONE, XCB_CURSOR_NONE, XCB_CURRENT_TIME);
+#if X11_Xinput_FOUND
+    xcb_input_xi_query_device_cookie_t devicesCookie = {0};
+    if (m_hasXInput2) {
+        devicesCookie = xcb_input_xi_query_device(c, XCB_INPUT_DEVICE_ALL_MASTER);
     }
+#endif
 
-    if (!grabMouse()) {
-        XUngrabKeyboard(QX11Info::display(), CurrentTime);
-        XFlush(QX11Info::display());
+    QScopedPointer<xcb_grab_keyboard_reply_t, QScopedPointerPodDeleter> keyboardReply(xcb_grab_keyboard_reply(c, keyboardCookie, nullptr));
+    QScopedPointer<xcb_grab_pointer_reply_t, QScopedPointerPodDeleter> pointerReply(xcb_grab_pointer_reply(c, pointerCookie, nullptr));
+    const bool keyboardGrabbed = !keyboardReply.isNull() && keyboardReply->status == XCB_GRAB_STATUS_SUCCESS;
+    const bool pointerGrabbed = !pointerReply.isNull() && pointerReply->status == XCB_GRAB_STATUS_SUCCESS;
+    if (!keyboardGrabbed || !pointerGrabbed) {
+#if X11_Xinput_FOUND
+        if (m_hasXInput2) {
+            xcb_discard_reply(c, devicesCookie.sequence);
+        }
+#endif
+        if (keyboardGrabbed) {
+            xcb_ungrab_keyboard(c, XCB_CURRENT_TIME);
+        }
+        if (pointerGrabbed) {
+            xcb_ungrab_pointer(c, XCB_CURRENT_TIME);
+        }
         return false;
     }
 
 #if X11_Xinput_FOUND
     if (m_hasXInput2) {
-        // get all devices
-        Display *dpy = QX11Info::display();
-        int numMasters;
-        XIDeviceInfo *masters = XIQueryDevice(dpy, XIAllMasterDevices, &numMasters);
-        bool success = true;
-        for (int i = 0; i < numMasters; ++i) {
+        QScopedPointer<xcb_input_xi_query_device_reply_t, QScopedPointerPodDeleter> devices(xcb_input_xi_query_device_reply(c, devicesCookie, nullptr));
+        if (devices.isNull()) {
+            xcb_ungrab_keyboard(c, XCB_CURRENT_TIME);
+            xcb_ungrab_pointer(c, XCB_CURRENT_TIME);
+            return false;
+        }
+
+        const uint32_t mask = XCB_INPUT_XI_EVENT_MASK_BUTTON_PRESS | XCB_INPUT_XI_EVENT_MASK_BUTTON_RELEASE | XCB_INPUT_XI_EVENT_MASK_MOTION
+            | XCB_INPUT_XI_EVENT_MASK_ENTER | XCB_INPUT_XI_EVENT_MASK_LEAVE;
+        QVector<xcb_input_device_id_t> masters;
+        QVector<xcb_input_xi_grab_device_cookie_t> grabCookies;
+        for (auto it = xcb_input_xi_query_device_infos_iterator(devices.data()); it.rem; xcb_input_xi_device_info_next(&it)) {
+            masters << it.data->deviceid;
             // ignoring core pointer and core keyboard as we already grabbed them
-            if (qstrcmp(masters[i].name, "Virtual core pointer") == 0) {
-                continue;
-            }
-            if (qstrcmp(masters[i].name, "Virtual core keyboard") == 0) {
+            const QByteArray name = QByteArray::fromRawData(xcb_input_xi_device_info_name(it.data), it.data->name_len);
+            if (name == "Virtual core pointer" || name == "Virtual core keyboard") {
                 continue;
             }
-            XIEventMask mask;
-            uchar bitmask[] = {0, 0};
-            mask.deviceid = masters[i].deviceid;
-            mask.mask = bitmask;
-            mask.mask_len = sizeof(bitmask);
-            XISetMask(bitmask, XI_ButtonPress);
-            XISetMask(bitmask, XI_ButtonRelease);
-            XISetMask(bitmask, XI_Motion);
-            XISetMask(bitmask, XI_Enter);
-            XISetMask(bitmask, XI_Leave);
-            const int result = XIGrabDevice(dpy,
-                                            masters[i].deviceid,
-                                            QX11Info::appRootWindow(),
-                                            XCB_TIME_CURRENT_TIME,
-                                            XCB_CURSOR_NONE,
-                                            XIGrabModeAsync,
-                                            XIGrabModeAsync,
-                                            True,
-                                            &mask);
-            if (result != XIGrabSuccess) {
+            grabCookies << xcb_input_xi_grab_device(c,
+                                                    root,
+                                                    XCB_CURRENT_TIME,
+                                                    XCB_CURSOR_NONE,
+                                                    it.data->deviceid,
+                                                    XCB_INPUT_GRAB_MODE_22_ASYNC,
+                                                    XCB_INPUT_GRAB_MODE_22_ASYNC,
+                                                    XCB_INPUT_GRAB_OWNER_OWNER,
+                                                    1,
+                                                    &mask);
+        }
+
+        bool success = true;
+        for (const auto &cookie : qAsConst(grabCookies)) {
+            QScopedPointer<xcb_input_xi_grab_device_reply_t, QScopedPointerPodDeleter> reply(xcb_input_xi_grab_device_reply(c, cookie, nullptr));
+            if (reply.isNull() || reply->status != XCB_GRAB_STATUS_SUCCESS) {
                 success = false;
-                break;
             }
         }
         if (!success) {
             // ungrab all devices again
-            for (int i = 0; i < numMasters; ++i) {
-                XIUngrabDevice(dpy, masters[i].deviceid, XCB_TIME_CURRENT_TIME);
+            for (const auto deviceId : qAsConst(masters)) {
+                xcb_input_xi_ungrab_device(c, XCB_CURRENT_TIME, deviceId);
             }
-            xcb_connection_t *c = QX11Info::connection();
             xcb_ungrab_keyboard(c, XCB_CURRENT_TIME);
             xcb_ungrab_pointer(c, XCB_CURRENT_TIME);
         }
-        XIFreeDeviceInfo(masters);
-        XFlush(dpy);
         return success;
     }
 #endif
@@ -513,24 +678,9 @@ bool KSldApp::establishGrab()
     return true;
 }
 
-static bool grabKeyboard()
-{
-    int rv = XGrabKeyboard(QX11Info::display(), QX11Info::appRootWindow(), True, GrabModeAsync, GrabModeAsync, CurrentTime);
-
-    return (rv == GrabSuccess);
-}
-
-static bool grabMouse()
-{
-#define GRABEVENTS ButtonPressMask | ButtonReleaseMask | PointerMotionMask | EnterWindowMask | LeaveWindowMask
-    int rv = XGrabPointer(QX11Info::display(), QX11Info::appRootWindow(), True, GRABEVENTS, GrabModeAsync, GrabModeAsync, None, None, CurrentTime);
-#undef GRABEVENTS
-
-    return (rv == GrabSuccess);
-}
-
 void KSldApp::doUnlock()
 {
+    m_lockLatency->startUnlock();
     qCDebug(KSCREENLOCKER) << "Grab Released";
     if (m_isX11) {
         xcb_connection_t *c = QX11Info::connection();
@@ -552,18 +702,27 @@ void KSldApp::doUnlock()
         }
 #endif
     }
+    m_lockLatency->mark(LockLatencyTracker::Phase::GrabReleased);
     hideLockWindow();
-    // delete the window again, to get rid of event filter
-    delete m_lockWindow;
-    m_lockWindow = nullptr;
+    // the X11 locker keeps tracking the toplevel windows for the next lock
+    if (!m_isX11) {
+        delete m_lockWindow;
+        m_lockWindow = nullptr;
+    }
     m_lockState = Unlocked;
     m_lockedTimer.invalidate();
     m_greeterCrashedCounter = 0;
+    m_suspendLock = false;
+    m_suspendLockDeadline->stop();
+    m_greeterReadyDeadline->stop();
     endGraceTime();
     m_waylandServer->stop();
     KNotification::event(QStringLiteral("unlocked"), i18n("Screen unlocked"), QPixmap(), nullptr, KNotification::CloseOnTimeout, QStringLiteral("ksmserver"));
     Q_EMIT unlocked();
     Q_EMIT lockStateChanged();
+    m_lockLatency->mark(LockLatencyTracker::Phase::Unlocked);
+    // prepare the greeter for the next lock once the old one is fully gone
+    QMetaObject::invokeMethod(this, &KSldApp::startStandbyGreeter, Qt::QueuedConnection);
 }
 
 bool KSldApp::isFdoPowerInhibited() const
@@ -578,12 +737,20 @@ void KSldApp::setWaylandFd(int fd)
 
 void KSldApp::startLockProcess(EstablishLock establishLock)
 {
-    QProcessEnvironment env = m_greeterEnv;
-
-    if (m_isWayland && m_waylandFd >= 0) {
-        int socket = dup(m_waylandFd);
-        if (socket >= 0) {
-            env.insert(QStringLiteral("WAYLAND_SOCKET"), QString::number(socket));
+    m_greeterReadyDeadline->start();
+    if (m_greeterInStandby) {
+        m_greeterInStandby = false;
+        // a greeter being stopped exits anyway and is handled like a crashed one
+        m_greeterStandbyStopping = false;
+        if (m_lockProcess->state() != QProcess::NotRunning) {
+            // the greeter is already prepared, it only needs to show the lock screen
+            qCDebug(KSCREENLOCKER) << "Activating standby greeter";
+            m_lockLatency->mark(LockLatencyTracker::Phase::GreeterStarted);
+            m_waylandServer->activateGreeter(establishLock != EstablishLock::Delayed,
+                                             qMax(m_lockGrace, 0),
+                                             m_lockGrace == -1,
+                                             establishLock == EstablishLock::DefaultToSwitchUser);
+            return;
         }
     }
 
@@ -603,6 +770,20 @@ void KSldApp::startLockProcess(EstablishLock establishLock)
     if (m_lockGrace == -1) {
         args << QStringLiteral("--nolock");
     }
+
+    launchGreeter(m_greeterEnv, args);
+}
+
+bool KSldApp::launchGreeter(QProcessEnvironment env, QStringList args)
+{
+    int socket = -1;
+    if (m_isWayland && m_waylandFd >= 0) {
+        socket = dup(m_waylandFd);
+        if (socket >= 0) {
+            env.insert(QStringLiteral("WAYLAND_SOCKET"), QString::number(socket));
+        }
+    }
+
     if (m_forceSoftwareRendering) {
         env.insert(s_qtQuickBackend, QStringLiteral("software"));
     }
@@ -611,62 +792,94 @@ void KSldApp::startLockProcess(EstablishLock establishLock)
     int fd = m_waylandServer->start();
     if (fd == -1) {
         qCWarning(KSCREENLOCKER) << "Could not start the Wayland server.";
-        Q_EMIT m_lockProcess->errorOccurred(QProcess::FailedToStart);
-        return;
+        if (socket >= 0) {
+            close(socket);
+        }
+        QMetaObject::invokeMethod(
+            m_lockProcess,
+            [this]() {
+                Q_EMIT m_lockProcess->errorOccurred(QProcess::FailedToStart);
+            },
+            Qt::QueuedConnection);
+        return false;
     }
 
     args << QStringLiteral("--ksldfd");
     args << QString::number(fd);
 
-    auto greeterPath = KLibexec::path(QStringLiteral(KSCREENLOCKER_GREET_BIN_REL));
-    if (!QFile::exists(greeterPath)) {
-        greeterPath = KSCREENLOCKER_GREET_BIN_ABS;
+    auto greeterPath = m_greeterPath;
+    if (greeterPath.isEmpty()) {
+        greeterPath = KLibexec::path(QStringLiteral(KSCREENLOCKER_GREET_BIN_REL));
+        if (!QFile::exists(greeterPath)) {
+            greeterPath = KSCREENLOCKER_GREET_BIN_ABS;
+        }
     }
 
-    m_lockProcess->setProcessEnvironment(env);
-    m_lockProcess->start(greeterPath, args);
+    const bool started = m_lockProcess->start(greeterPath, args, env);
+    // the greeter inherited its own copies of the file descriptors
     close(fd);
+    if (socket >= 0) {
+        close(socket);
+    }
+    return started;
 }
 
 void KSldApp::userActivity()
 {
-    if (isGraceTime()) {
-        unlock();
-    }
     if (m_lockWindow) {
-        m_lockWindow->userActivity();
+        m_lockWindow->notifyUserActivity();
     }
 }
 
-void KSldApp::showLockWindow()
+void KSldApp::createLockWindow()
 {
-    if (!m_lockWindow) {
-        if (m_isX11) {
-            m_lockWindow = new X11Locker(this);
+    if (m_lockWindow) {
+        return;
+    }
+    if (m_isX11) {
+        m_lockWindow = new X11Locker(this);
+    }
 
-            connect(
-                m_lockWindow,
-                &AbstractLocker::userActivity,
-                m_lockWindow,
-                [this]() {
-                    if (isGraceTime()) {
-                        unlock();
-                    }
-                },
-                Qt::QueuedConnection);
-        }
+    if (m_isWayland) {
+        m_lockWindow = new WaylandLocker(this);
+    }
+    if (!m_lockWindow) {
+        return;
+    }
+    m_lockWindow->setGlobalAccel(m_globalAccel);
 
-        if (m_isWayland) {
-            m_lockWindow = new WaylandLocker(this);
+    connect(
+        m_lockWindow,
+        &AbstractLocker::userActivity,
+        m_lockWindow,
+        [this]() {
+            if (isGraceTime()) {
+                unlock();
+            }
+        },
+        Qt::QueuedConnection);
+
+    // the screen only counts as locked once the greeter reports that it is on screen
+    connect(m_lockWindow, &AbstractLocker::lockWindowShown, this, [this]() {
+        m_lockLatency->mark(LockLatencyTracker::Phase::LockScreenShown);
+        if (m_suspendLock) {
+            // the desktop is covered, no need to delay the suspend for the greeter
+            m_logind->uninhibit();
         }
-        if (!m_lockWindow) {
-            return;
+        if (m_waylandServer->isGreeterBound() && !m_waylandServer->canGreeterReportReady()) {
+            // a greeter from before the ready request, its window being shown is all we get
+            lockScreenShown();
         }
-        m_lockWindow->setGlobalAccel(m_globalAccel);
+    });
 
-        connect(m_lockWindow, &AbstractLocker::lockWindowShown, this, &KSldApp::lockScreenShown);
+    connect(m_waylandServer, &WaylandServer::x11WindowAdded, m_lockWindow, &AbstractLocker::addAllowedWindow);
+}
 
-        connect(m_waylandServer, &WaylandServer::x11WindowAdded, m_lockWindow, &AbstractLocker::addAllowedWindow);
+void KSldApp::showLockWindow()
+{
+    createLockWindow();
+    if (!m_lockWindow) {
+        return;
     }
     m_lockWindow->showLockWindow();
     if (m_isX11) {
@@ -706,6 +919,7 @@ void KSldApp::unlock()
     if (!isGraceTime()) {
         return;
     }
+    m_lockLatency->startUnlock();
     s_graceTimeKill = true;
     m_lockProcess->terminate();
 }
@@ -720,6 +934,16 @@ void KSldApp::uninhibit()
     --m_inhibitCounter;
 }
 
+void KSldApp::setThrottled(bool throttled)
+{
+    m_waylandServer->setThrottled(throttled);
+}
+
+bool KSldApp::isThrottled() const
+{
+    return m_waylandServer->isThrottled();
+}
+
 void KSldApp::solidSuspend()
 {
     // ignore in case that we use logind
@@ -740,6 +964,12 @@ void KSldApp::lockScreenShown()
     m_lockedTimer.restart();
     Q_EMIT locked();
     Q_EMIT lockStateChanged();
+    m_lockLatency->mark(LockLatencyTracker::Phase::Locked);
+}
+
+QVariantMap KSldApp::lockLatency() const
+{
+    return m_lockLatency->report();
 }
 
 void KSldApp::setGreeterEnvironment(const QProcessEnvironment &env)
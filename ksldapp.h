@@ -25,6 +25,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QElapsedTimer>
 #include <QProcessEnvironment>
+#include <QVariantMap>
+
+#include <memory>
 
 #include <KScreenLocker/kscreenlocker_export.h>
 
@@ -33,6 +36,7 @@ class GlobalAccel;
 class LogindIntegration;
 class QTimer;
 class KSldTest;
+class KSldBenchmark;
 class PowerManagementInhibition;
 
 namespace ScreenLocker
@@ -44,6 +48,8 @@ enum class EstablishLock {
 };
 
 class AbstractLocker;
+class GreeterProcess;
+class LockLatencyTracker;
 class WaylandServer;
 
 class KSCREENLOCKER_EXPORT KSldApp : public QObject
@@ -83,12 +89,22 @@ public:
 
     void setGreeterEnvironment(const QProcessEnvironment &env);
 
+    /**
+     * @returns the durations of the individual phases of the recent lock and unlock cycles.
+     **/
+    QVariantMap lockLatency() const;
+
     /**
      * Can be used by the lock window to remove the lock during grace time.
      **/
     void unlock();
     void inhibit();
     void uninhibit();
+    /**
+     * Puts the greeter into a reduced rendering mode while @p throttled.
+     **/
+    void setThrottled(bool throttled);
+    bool isThrottled() const;
 
     void lock(EstablishLock establishLock, int attemptCount = 0);
     void initialize();
@@ -120,6 +136,22 @@ public:
         m_lockGrace = msec;
     }
 
+    /**
+     * For testing
+     * @internal
+     **/
+    void setGreeterStandbyEnabled(bool enabled);
+
+    /**
+     * Overrides the greeter binary to start.
+     * For testing
+     * @internal
+     **/
+    void setGreeterPath(const QString &path)
+    {
+        m_greeterPath = path;
+    }
+
     bool forceSoftwareRendering() const
     {
         return m_forceSoftwareRendering;
@@ -148,13 +180,21 @@ private:
     void initializeX11();
     bool establishGrab();
     void startLockProcess(EstablishLock establishLock);
+    /**
+     * Returns whether the greeter got spawned. Otherwise m_lockProcess reports
+     * QProcess::FailedToStart from the event loop.
+     **/
+    bool launchGreeter(QProcessEnvironment env, QStringList args);
+    void startStandbyGreeter();
+    void restartStandbyGreeter();
+    void createLockWindow();
     void showLockWindow();
     void hideLockWindow();
     void doUnlock();
     bool isFdoPowerInhibited() const;
 
     LockState m_lockState;
-    QProcess *m_lockProcess;
+    GreeterProcess *m_lockProcess;
     AbstractLocker *m_lockWindow;
     WaylandServer *m_waylandServer;
 
@@ -177,6 +217,21 @@ private:
      * Grace time ends when timer expires.
      **/
     QTimer *m_graceTimer;
+    /**
+     * The lock got started because the system is going to sleep. The sleep inhibitor
+     * gets released as soon as the background covers the screen, provided no compositor
+     * delays painting it. Otherwise it is kept till the greeter is shown.
+     **/
+    bool m_suspendLock = false;
+    /**
+     * Deadline for the greeter to come up after resuming from a suspend lock.
+     **/
+    QTimer *m_suspendLockDeadline;
+    /**
+     * Deadline for the greeter to report being ready, started with each greeter start
+     * or activation. Covers greeters which never present a frame.
+     **/
+    QTimer *m_greeterReadyDeadline;
     int m_inhibitCounter;
     LogindIntegration *m_logind;
     GlobalAccel *m_globalAccel = nullptr;
@@ -186,13 +241,29 @@ private:
     bool m_isX11;
     bool m_isWayland;
     int m_greeterCrashedCounter = 0;
+    /**
+     * Whether a greeter should be kept prepared in the background while unlocked.
+     **/
+    bool m_greeterStandbyEnabled = false;
+    /**
+     * The greeter process is running in standby mode and did not get activated yet.
+     **/
+    bool m_greeterInStandby = false;
+    /**
+     * The standby greeter got terminated because standby got disabled or to pick up a
+     * changed configuration. A new one is started once it exited if standby is enabled.
+     **/
+    bool m_greeterStandbyStopping = false;
     QProcessEnvironment m_greeterEnv;
     PowerManagementInhibition *m_powerManagementInhibition;
+    std::unique_ptr<LockLatencyTracker> m_lockLatency;
 
     int m_waylandFd = -1;
+    QString m_greeterPath;
 
     // for auto tests
     friend KSldTest;
+    friend KSldBenchmark;
 };
 } // namespace
 
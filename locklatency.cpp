@@ -0,0 +1,156 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "locklatency.h"
+
+#include "kscreenlocker_logging.h"
+
+#include <algorithm>
+
+#include <time.h>
+
+namespace ScreenLocker
+{
+LockLatencyTracker::LockLatencyTracker()
+    : m_recorded(s_phaseCount, false)
+    , m_samples(s_phaseCount)
+{
+}
+
+void LockLatencyTracker::startLock()
+{
+    start(Cycle::Lock);
+}
+
+void LockLatencyTracker::startUnlock()
+{
+    if (m_cycle == Cycle::Unlock) {
+        return;
+    }
+    start(Cycle::Unlock);
+}
+
+void LockLatencyTracker::start(Cycle cycle)
+{
+    m_cycle = cycle;
+    m_recorded.fill(false);
+    m_cycleStart = now();
+}
+
+qint64 LockLatencyTracker::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+LockLatencyTracker::Cycle LockLatencyTracker::cycleForPhase(Phase phase)
+{
+    return phase < Phase::GreeterExited ? Cycle::Lock : Cycle::Unlock;
+}
+
+void LockLatencyTracker::mark(Phase phase)
+{
+    markAt(phase, now());
+}
+
+void LockLatencyTracker::markAt(Phase phase, qint64 timestamp)
+{
+    if (m_cycle == Cycle::None || cycleForPhase(phase) != m_cycle) {
+        return;
+    }
+    const int index = int(phase);
+    if (m_recorded.at(index)) {
+        return;
+    }
+    m_recorded[index] = true;
+
+    const qint64 elapsed = timestamp - m_cycleStart;
+    Samples &samples = m_samples[index];
+    if (samples.values.size() < s_maxSamples) {
+        samples.values.append(elapsed);
+    } else {
+        samples.values[samples.next] = elapsed;
+    }
+    samples.next = (samples.next + 1) % s_maxSamples;
+    samples.last = elapsed;
+
+    if (phase == Phase::Locked || phase == Phase::Unlocked) {
+        qCDebug(KSCREENLOCKER) << phaseName(phase) << "after" << elapsed / 1000000.0 << "ms";
+        m_cycle = Cycle::None;
+    }
+}
+
+QString LockLatencyTracker::phaseName(Phase phase)
+{
+    switch (phase) {
+    case Phase::GrabEstablished:
+        return QStringLiteral("grabEstablished");
+    case Phase::LockWindowShown:
+        return QStringLiteral("lockWindowShown");
+    case Phase::GreeterStarted:
+        return QStringLiteral("greeterStarted");
+    case Phase::GreeterLocked:
+        return QStringLiteral("greeterLocked");
+    case Phase::LockScreenShown:
+        return QStringLiteral("lockScreenShown");
+    case Phase::FirstFrame:
+        return QStringLiteral("firstFrame");
+    case Phase::GreeterReady:
+        return QStringLiteral("greeterReady");
+    case Phase::Locked:
+        return QStringLiteral("locked");
+    case Phase::GreeterExited:
+        return QStringLiteral("greeterExited");
+    case Phase::GrabReleased:
+        return QStringLiteral("grabReleased");
+    case Phase::Unlocked:
+        return QStringLiteral("unlocked");
+    }
+    Q_UNREACHABLE();
+}
+
+static double percentile(const QVector<qint64> &sorted, int percent)
+{
+    // nearest-rank method
+    const int rank = qMax(1, (percent * sorted.size() + 99) / 100);
+    return sorted.at(rank - 1) / 1000000.0;
+}
+
+QVariantMap LockLatencyTracker::report() const
+{
+    QVariantMap result;
+    for (int i = 0; i < s_phaseCount; ++i) {
+        const Samples &samples = m_samples.at(i);
+        if (samples.values.isEmpty()) {
+            continue;
+        }
+        QVector<qint64> sorted = samples.values;
+        std::sort(sorted.begin(), sorted.end());
+
+        QVariantMap phase;
+        phase.insert(QStringLiteral("samples"), sorted.size());
+        phase.insert(QStringLiteral("last"), samples.last / 1000000.0);
+        phase.insert(QStringLiteral("p50"), percentile(sorted, 50));
+        phase.insert(QStringLiteral("p95"), percentile(sorted, 95));
+        phase.insert(QStringLiteral("p99"), percentile(sorted, 99));
+        result.insert(phaseName(Phase(i)), phase);
+    }
+    return result;
+}
+
+}
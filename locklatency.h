@@ -0,0 +1,110 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef SCREENLOCKER_LOCKLATENCY_H
+#define SCREENLOCKER_LOCKLATENCY_H
+
+#include <QVariantMap>
+#include <QVector>
+
+namespace ScreenLocker
+{
+/**
+ * Records how long the individual phases of locking and unlocking take.
+ *
+ * A lock or unlock cycle gets started with startLock() or startUnlock(), each
+ * phase reached afterwards is recorded as the time passed since the start of
+ * the cycle. All times are taken from CLOCK_MONOTONIC so that timestamps
+ * reported by the greeter can be related to them. The last samples of every
+ * phase are kept to provide percentiles.
+ **/
+class LockLatencyTracker
+{
+public:
+    enum class Phase {
+        // lock cycle
+        GrabEstablished,
+        LockWindowShown,
+        GreeterStarted,
+        GreeterLocked,
+        LockScreenShown,
+        FirstFrame,
+        GreeterReady,
+        Locked,
+        // unlock cycle
+        GreeterExited,
+        GrabReleased,
+        Unlocked,
+    };
+
+    LockLatencyTracker();
+
+    /**
+     * Starts a new lock cycle, discarding any unfinished cycle.
+     **/
+    void startLock();
+    /**
+     * Starts a new unlock cycle unless one is already in progress.
+     **/
+    void startUnlock();
+    /**
+     * Records @p phase for the current cycle. Phases not belonging to the
+     * current cycle or already recorded in it are ignored. Reaching Locked
+     * or Unlocked finishes the cycle.
+     **/
+    void mark(Phase phase);
+    /**
+     * Like mark(), but records @p phase as reached at @p timestamp, which is
+     * a CLOCK_MONOTONIC time in nanoseconds.
+     **/
+    void markAt(Phase phase, qint64 timestamp);
+
+    /**
+     * @returns a map with an entry for each phase, containing the number of samples
+     * and the last value, p50, p95 and p99 in milliseconds.
+     **/
+    QVariantMap report() const;
+
+private:
+    enum class Cycle {
+        None,
+        Lock,
+        Unlock,
+    };
+    static const int s_phaseCount = int(Phase::Unlocked) + 1;
+    static const int s_maxSamples = 128;
+
+    struct Samples {
+        QVector<qint64> values;
+        int next = 0;
+        qint64 last = 0;
+    };
+
+    void start(Cycle cycle);
+    static Cycle cycleForPhase(Phase phase);
+    static QString phaseName(Phase phase);
+    static qint64 now();
+
+    Cycle m_cycle = Cycle::None;
+    qint64 m_cycleStart = 0;
+    QVector<bool> m_recorded;
+    QVector<Samples> m_samples;
+};
+
+}
+
+#endif
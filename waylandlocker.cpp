@@ -28,8 +28,8 @@ namespace ScreenLocker
 WaylandLocker::WaylandLocker(QObject *parent)
     : AbstractLocker(parent)
 {
-    if (m_background) {
-        updateGeometryOfBackground();
+    // the background is only needed for the emergency mode and created on demand
+    if (qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
         const auto screens = qApp->screens();
         for (auto s : screens) {
             connect(s, &QScreen::geometryChanged, this, &WaylandLocker::updateGeometryOfBackground);
@@ -48,6 +48,9 @@ WaylandLocker::~WaylandLocker()
 
 void WaylandLocker::updateGeometryOfBackground()
 {
+    if (m_background.isNull()) {
+        return;
+    }
     QRect combined;
     const auto screens = qApp->screens();
     for (auto s : screens) {
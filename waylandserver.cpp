@@ -89,7 +89,7 @@ int WaylandServer::start()
     }
     wl_client_add_destroy_listener(m_greeter, &m_listener.listener);
 
-    m_interface = wl_global_create(m_display, &org_kde_ksld_interface, 3, this, bind);
+    m_interface = wl_global_create(m_display, &org_kde_ksld_interface, 6, this, bind);
     return socketPair[1];
 }
 
@@ -101,6 +101,8 @@ void WaylandServer::stop()
     delete m_notifier;
     m_notifier = nullptr;
 
+    m_activation = Activation();
+
     if (m_interface) {
         wl_global_destroy(m_interface);
         m_interface = nullptr;
@@ -115,6 +117,53 @@ void WaylandServer::stop()
     }
 }
 
+void WaylandServer::activateGreeter(bool immediateLock, int graceTime, bool noLock, bool switchUser)
+{
+    m_activation.pending = true;
+    m_activation.immediateLock = immediateLock;
+    m_activation.graceTime = graceTime;
+    m_activation.noLock = noLock;
+    m_activation.switchUser = switchUser;
+    sendActivate();
+}
+
+void WaylandServer::sendActivate()
+{
+    if (!m_activation.pending || !m_resource) {
+        return;
+    }
+    if (wl_resource_get_version(m_resource) < ORG_KDE_KSLD_ACTIVATE_SINCE_VERSION) {
+        qCWarning(KSCREENLOCKER) << "Greeter does not support activation from standby";
+        return;
+    }
+    org_kde_ksld_send_activate(m_resource, m_activation.immediateLock, m_activation.graceTime, m_activation.noLock, m_activation.switchUser);
+    m_activation.pending = false;
+    flush();
+}
+
+bool WaylandServer::canGreeterReportReady() const
+{
+    return m_resource && wl_resource_get_version(m_resource) >= ORG_KDE_KSLD_READY_SINCE_VERSION;
+}
+
+void WaylandServer::setThrottled(bool throttled)
+{
+    if (m_throttled == throttled) {
+        return;
+    }
+    m_throttled = throttled;
+    sendThrottle();
+}
+
+void WaylandServer::sendThrottle()
+{
+    if (!m_resource || wl_resource_get_version(m_resource) < ORG_KDE_KSLD_THROTTLE_SINCE_VERSION) {
+        return;
+    }
+    org_kde_ksld_send_throttle(m_resource, m_throttled);
+    flush();
+}
+
 void WaylandServer::flush()
 {
     wl_display_flush_clients(m_display);
@@ -136,7 +185,7 @@ void WaylandServer::bind(wl_client *client, void *data, uint32_t version, uint32
         return;
     }
 
-    wl_resource *resource = wl_resource_create(server->m_greeter, &org_kde_ksld_interface, qMin(version, 1u), id);
+    wl_resource *resource = wl_resource_create(server->m_greeter, &org_kde_ksld_interface, qMin(version, 6u), id);
     if (!resource) {
         wl_client_post_no_memory(client);
         return;
@@ -150,9 +199,45 @@ void WaylandServer::bind(wl_client *client, void *data, uint32_t version, uint32
                     Q_EMIT s->x11WindowAdded(id);
                 }
             },
+        .suspendSystem =
+            [](wl_client *client, wl_resource *resource) {
+                Q_UNUSED(client)
+                Q_UNUSED(resource)
+            },
+        .hibernateSystem =
+            [](wl_client *client, wl_resource *resource) {
+                Q_UNUSED(client)
+                Q_UNUSED(resource)
+            },
+        .ready =
+            [](wl_client *client, wl_resource *resource, wl_array *timestamps) {
+                auto s = reinterpret_cast<WaylandServer *>(wl_resource_get_user_data(resource));
+                if (s->m_greeter != client) {
+                    return;
+                }
+                QVector<quint64> firstFrames;
+                const auto data = static_cast<const uint64_t *>(timestamps->data);
+                for (size_t i = 0; i < timestamps->size / sizeof(uint64_t); ++i) {
+                    firstFrames << data[i];
+                }
+                Q_EMIT s->greeterReady(firstFrames);
+            },
     };
 
-    wl_resource_set_implementation(resource, &s_interface, server, nullptr);
+    wl_resource_set_implementation(resource, &s_interface, server, unbind);
+    server->m_resource = resource;
+    server->sendActivate();
+    if (server->m_throttled) {
+        server->sendThrottle();
+    }
+}
+
+void WaylandServer::unbind(wl_resource *resource)
+{
+    auto server = reinterpret_cast<WaylandServer *>(wl_resource_get_user_data(resource));
+    if (server->m_resource == resource) {
+        server->m_resource = nullptr;
+    }
 }
 
 }
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define SCREENLOCKER_WAYLANDSERVER_H
 
 #include <QSocketNotifier>
+#include <QVector>
 
 #include <wayland-server.h>
 
@@ -35,19 +36,62 @@ public:
     int start();
     void stop();
 
+    /**
+     * Tells a greeter started in standby mode to show the lock screen.
+     * If the greeter did not yet bind the interface the request is
+     * delivered as soon as it does.
+     **/
+    void activateGreeter(bool immediateLock, int graceTime, bool noLock, bool switchUser);
+    /**
+     * Tells the greeter whether to reduce its rendering. Kept across greeter restarts,
+     * a newly started greeter gets told once it binds the interface.
+     **/
+    void setThrottled(bool throttled);
+    bool isThrottled() const
+    {
+        return m_throttled;
+    }
+    bool isGreeterBound() const
+    {
+        return m_resource != nullptr;
+    }
+    /**
+     * Whether the bound greeter knows the ready request, which got added in version 5.
+     **/
+    bool canGreeterReportReady() const;
+
 Q_SIGNALS:
     void x11WindowAdded(quint32 window);
+    /**
+     * Emitted once the greeter presented the first frame on all screens.
+     * @param firstFrames CLOCK_MONOTONIC timestamps in nanoseconds of the first frame of each screen
+     **/
+    void greeterReady(const QVector<quint64> &firstFrames);
 
 private:
     void flush();
     void dispatchEvents();
 
+    void sendActivate();
+    void sendThrottle();
+
     static void bind(wl_client *client, void *data, uint32_t version, uint32_t id);
+    static void unbind(wl_resource *resource);
 
     QSocketNotifier *m_notifier = nullptr;
     ::wl_display *m_display = nullptr;
     ::wl_client *m_greeter = nullptr;
     ::wl_global *m_interface = nullptr;
+    ::wl_resource *m_resource = nullptr;
+
+    struct Activation {
+        bool pending = false;
+        bool immediateLock = false;
+        int graceTime = 0;
+        bool noLock = false;
+        bool switchUser = false;
+    } m_activation;
+    bool m_throttled = false;
 
     struct Listener {
         ::wl_listener listener;
@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #endif
 // X11
 #include <X11/Xatom.h>
+#include <xcb/composite.h>
 #include <xcb/xcb.h>
 
 #include <kscreenlocker_logging.h>
@@ -43,6 +44,8 @@ static Window gVRoot = 0;
 static Window gVRootData = 0;
 static Atom gXA_VROOT;
 static Atom gXA_SCREENSAVER_VERSION;
+// upper bound for the toplevel windows tracked between locks
+static const int s_maxTrackedWindows = 65536;
 
 namespace ScreenLocker
 {
@@ -51,44 +54,44 @@ X11Locker::X11Locker(QObject *parent)
     , QAbstractNativeEventFilter()
     , m_focusedLockWindow(XCB_WINDOW_NONE)
 {
+    ensureBackground();
     initialize();
 }
 
 X11Locker::~X11Locker()
 {
     qApp->removeNativeEventFilter(this);
+    releaseCompositeOverlay();
 }
 
 void X11Locker::initialize()
 {
     qApp->installNativeEventFilter(this);
 
-    XWindowAttributes rootAttr;
-    XGetWindowAttributes(QX11Info::display(), QX11Info::appRootWindow(), &rootAttr);
-    XSelectInput(QX11Info::display(), QX11Info::appRootWindow(), SubstructureNotifyMask | rootAttr.your_event_mask);
+    // All requests get sent before waiting for any reply, so that the number of round trips
+    // does not depend on the number of toplevel windows.
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_window_t root = QX11Info::appRootWindow();
+    const auto rootAttributesCookie = xcb_get_window_attributes(c, root);
+    // virtual root property
+    const auto vrootCookie = xcb_intern_atom(c, false, strlen("__SWM_VROOT"), "__SWM_VROOT");
+    const auto versionCookie = xcb_intern_atom(c, false, strlen("_SCREENSAVER_VERSION"), "_SCREENSAVER_VERSION");
+
+    QScopedPointer<xcb_get_window_attributes_reply_t, QScopedPointerPodDeleter> rootAttributes(xcb_get_window_attributes_reply(c, rootAttributesCookie, nullptr));
+    const uint32_t eventMask = XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | (rootAttributes.isNull() ? 0 : rootAttributes->your_event_mask);
+    xcb_change_window_attributes(c, root, XCB_CW_EVENT_MASK, &eventMask);
+    // only query the tree after selecting for the notifies to not miss any window in between
+    const auto treeCookie = xcb_query_tree(c, root);
+
+    QScopedPointer<xcb_intern_atom_reply_t, QScopedPointerPodDeleter> vrootAtom(xcb_intern_atom_reply(c, vrootCookie, nullptr));
+    gXA_VROOT = vrootAtom.isNull() ? XCB_ATOM_NONE : vrootAtom->atom;
+    QScopedPointer<xcb_intern_atom_reply_t, QScopedPointerPodDeleter> versionAtom(xcb_intern_atom_reply(c, versionCookie, nullptr));
+    gXA_SCREENSAVER_VERSION = versionAtom.isNull() ? XCB_ATOM_NONE : versionAtom->atom;
+
     // Get root window size
     updateGeo();
 
-    // virtual root property
-    gXA_VROOT = XInternAtom(QX11Info::display(), "__SWM_VROOT", False);
-    gXA_SCREENSAVER_VERSION = XInternAtom(QX11Info::display(), "_SCREENSAVER_VERSION", False);
-
-    // read the initial information about all toplevel windows
-    Window r, p;
-    Window *real;
-    unsigned nreal;
-    if (XQueryTree(QX11Info::display(), QX11Info::appRootWindow(), &r, &p, &real, &nreal) && real != nullptr) {
-        for (unsigned i = 0; i < nreal; ++i) {
-            XWindowAttributes winAttr;
-            if (XGetWindowAttributes(QX11Info::display(), real[i], &winAttr)) {
-                WindowInfo info;
-                info.window = real[i];
-                info.viewable = (winAttr.map_state == IsViewable);
-                m_windowInfo.append(info); // ordered bottom to top
-            }
-        }
-        XFree(real);
-    }
+    discoverToplevels(treeCookie);
 
     // monitor for screen geometry changes
     connect(qGuiApp, &QGuiApplication::screenAdded, this, [this](QScreen *screen) {
@@ -102,8 +105,40 @@ void X11Locker::initialize()
     }
 }
 
+void X11Locker::discoverToplevels(xcb_query_tree_cookie_t treeCookie)
+{
+    xcb_connection_t *c = QX11Info::connection();
+    m_windowStack.clear();
+
+    // read the information about all toplevel windows
+    QScopedPointer<xcb_query_tree_reply_t, QScopedPointerPodDeleter> tree(xcb_query_tree_reply(c, treeCookie, nullptr));
+    if (!tree.isNull()) {
+        const xcb_window_t *children = xcb_query_tree_children(tree.data());
+        const int childrenCount = xcb_query_tree_children_length(tree.data());
+        QVector<xcb_get_window_attributes_cookie_t> cookies;
+        cookies.reserve(childrenCount);
+        for (int i = 0; i < childrenCount; ++i) {
+            cookies << xcb_get_window_attributes(c, children[i]);
+        }
+        for (int i = 0; i < childrenCount; ++i) {
+            xcb_generic_error_t *error = nullptr;
+            QScopedPointer<xcb_get_window_attributes_reply_t, QScopedPointerPodDeleter> attributes(xcb_get_window_attributes_reply(c, cookies.at(i), &error));
+            // the window might be gone already
+            free(error);
+            if (!attributes.isNull()) {
+                // the children are ordered bottom to top
+                m_windowStack.addOnTop(children[i], attributes->map_state == XCB_MAP_STATE_VIEWABLE);
+            }
+        }
+    }
+    qCDebug(KSCREENLOCKER) << "Tracking" << m_windowStack.size() << "toplevel windows";
+}
+
 void X11Locker::showLockWindow()
 {
+    qCDebug(KSCREENLOCKER) << "Tracking" << m_windowStack.size() << "toplevel windows in" << m_windowStack.memoryUsage() << "bytes";
+    m_locked = true;
+    m_inputStatistics = InputStatistics();
     m_background->hide();
 
     // Some xscreensaver hacks check for this property
@@ -120,10 +155,99 @@ void X11Locker::showLockWindow()
 
     qCDebug(KSCREENLOCKER) << "Lock window Id: " << m_background->winId();
 
+    // the X server fills the background window, without any pixels on our side and already
+    // as part of mapping it, so the screen is covered once the MapNotify arrives
+    const uint32_t black = BlackPixel(QX11Info::display(), QX11Info::appScreen());
+    xcb_change_window_attributes(QX11Info::connection(), m_background->winId(), XCB_CW_BACK_PIXEL, &black);
+
     m_background->setPosition(0, 0);
     XSync(QX11Info::display(), False);
 
     setVRoot(m_background->winId(), m_background->winId());
+
+    if (m_useCompositeOverlay) {
+        acquireCompositeOverlay();
+    }
+}
+
+void X11Locker::setUseCompositeOverlay(bool use)
+{
+    m_useCompositeOverlay = use;
+}
+
+void X11Locker::acquireCompositeOverlay()
+{
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(c, &xcb_composite_id);
+    if (!extension || !extension->present) {
+        qCWarning(KSCREENLOCKER) << "Composite extension not available, keeping the lock windows on top by restacking";
+        return;
+    }
+    const xcb_window_t root = QX11Info::appRootWindow();
+    const auto versionCookie = xcb_composite_query_version(c, XCB_COMPOSITE_MAJOR_VERSION, XCB_COMPOSITE_MINOR_VERSION);
+    const auto overlayCookie = xcb_composite_get_overlay_window(c, root);
+    free(xcb_composite_query_version_reply(c, versionCookie, nullptr));
+    QScopedPointer<xcb_composite_get_overlay_window_reply_t, QScopedPointerPodDeleter> overlay(xcb_composite_get_overlay_window_reply(c, overlayCookie, nullptr));
+    if (overlay.isNull() || overlay->overlay_win == XCB_WINDOW_NONE) {
+        qCWarning(KSCREENLOCKER) << "Could not get the composite overlay window, keeping the lock windows on top by restacking";
+        return;
+    }
+    m_overlayWindow = overlay->overlay_win;
+
+    // The overlay window is above all regular and override redirect windows, everything inside of
+    // it stays on top without any restacking. The lock windows get moved into it once allowed.
+    const uint32_t eventMask = XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+    xcb_change_window_attributes(c, m_overlayWindow, XCB_CW_EVENT_MASK, &eventMask);
+    xcb_reparent_window(c, m_background->winId(), m_overlayWindow, 0, 0);
+    xcb_flush(c);
+    qCDebug(KSCREENLOCKER) << "Locking inside of the composite overlay window" << m_overlayWindow;
+}
+
+void X11Locker::releaseCompositeOverlay()
+{
+    if (m_overlayWindow == XCB_WINDOW_NONE) {
+        return;
+    }
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_window_t root = QX11Info::appRootWindow();
+    xcb_reparent_window(c, m_background->winId(), root, 0, 0);
+    xcb_composite_release_overlay_window(c, root);
+    xcb_flush(c);
+    m_overlayWindow = XCB_WINDOW_NONE;
+}
+
+bool X11Locker::isLockParent(xcb_window_t window) const
+{
+    return window == QX11Info::appRootWindow() || (m_overlayWindow != XCB_WINDOW_NONE && window == m_overlayWindow);
+}
+
+bool X11Locker::showBackground()
+{
+    // Without redirection the X server paints the background pixel as part of mapping the
+    // window, so its MapNotify means the outputs are black. A compositor paints it at some
+    // later point, which is not known to us.
+    if (isCompositingManagerRunning()) {
+        qCDebug(KSCREENLOCKER) << "Compositing manager running, waiting for the greeter to cover the screen";
+        return false;
+    }
+    m_background->show();
+    stayOnTop();
+    return true;
+}
+
+bool X11Locker::isCompositingManagerRunning() const
+{
+    xcb_connection_t *c = QX11Info::connection();
+    const QByteArray selection = QByteArrayLiteral("_NET_WM_CM_S") + QByteArray::number(QX11Info::appScreen());
+    QScopedPointer<xcb_intern_atom_reply_t, QScopedPointerPodDeleter> atom(
+        xcb_intern_atom_reply(c, xcb_intern_atom(c, false, selection.length(), selection.constData()), nullptr));
+    if (atom.isNull()) {
+        // better safe than sorry
+        return true;
+    }
+    QScopedPointer<xcb_get_selection_owner_reply_t, QScopedPointerPodDeleter> owner(
+        xcb_get_selection_owner_reply(c, xcb_get_selection_owner(c, atom->atom), nullptr));
+    return owner.isNull() || owner->owner != XCB_WINDOW_NONE;
 }
 
 //---------------------------------------------------------------------------
@@ -132,9 +256,10 @@ void X11Locker::showLockWindow()
 //
 void X11Locker::hideLockWindow()
 {
-    Q_EMIT userActivity();
+    notifyUserActivity();
     m_background->hide();
     m_background->lower();
+    releaseCompositeOverlay();
     removeVRoot(m_background->winId());
     XDeleteProperty(QX11Info::display(), m_background->winId(), gXA_SCREENSAVER_VERSION);
     if (gVRoot) {
@@ -143,13 +268,18 @@ void X11Locker::hideLockWindow()
         gVRoot = 0;
     }
     XSync(QX11Info::display(), False);
+    qCDebug(KSCREENLOCKER) << "Input events received:" << m_inputStatistics.received << "forwarded:" << m_inputStatistics.forwarded
+                           << "dropped:" << m_inputStatistics.dropped;
+    // the locker stays around for the next lock, only the stacking order is tracked meanwhile
+    m_locked = false;
+    m_pendingMotions.clear();
+    m_motionActivityPending = false;
+    m_restackPending = false;
+    m_background->resetEmergency();
     m_allowedWindows.clear();
-}
-
-//---------------------------------------------------------------------------
-static int ignoreXError(Display *, XErrorEvent *)
-{
-    return 0;
+    m_lockWindows.clear();
+    m_lockWindowGeometries.clear();
+    m_focusedLockWindow = XCB_WINDOW_NONE;
 }
 
 //---------------------------------------------------------------------------
@@ -158,50 +288,36 @@ static int ignoreXError(Display *, XErrorEvent *)
 //
 void X11Locker::saveVRoot()
 {
-    Window rootReturn, parentReturn, *children;
-    unsigned int numChildren;
-    Window root = QX11Info::appRootWindow();
+    xcb_connection_t *c = QX11Info::connection();
 
     gVRoot = 0;
     gVRootData = 0;
 
-    int (*oldHandler)(Display *, XErrorEvent *);
-    oldHandler = XSetErrorHandler(ignoreXError);
-
-    if (XQueryTree(QX11Info::display(), root, &rootReturn, &parentReturn, &children, &numChildren)) {
-        for (unsigned int i = 0; i < numChildren; i++) {
-            Atom actual_type;
-            int actual_format;
-            unsigned long nitems, bytesafter;
-            unsigned char *newRoot = nullptr;
-
-            if ((XGetWindowProperty(QX11Info::display(),
-                                    children[i],
-                                    gXA_VROOT,
-                                    0,
-                                    1,
-                                    False,
-                                    XA_WINDOW,
-                                    &actual_type,
-                                    &actual_format,
-                                    &nitems,
-                                    &bytesafter,
-                                    &newRoot)
-                 == Success)
-                && newRoot) {
-                gVRoot = children[i];
-                Window *dummy = (Window *)newRoot;
-                gVRootData = *dummy;
-                XFree((char *)newRoot);
-                break;
-            }
+    QScopedPointer<xcb_query_tree_reply_t, QScopedPointerPodDeleter> tree(xcb_query_tree_reply(c, xcb_query_tree(c, QX11Info::appRootWindow()), nullptr));
+    if (tree.isNull()) {
+        return;
+    }
+    const xcb_window_t *children = xcb_query_tree_children(tree.data());
+    const int childrenCount = xcb_query_tree_children_length(tree.data());
+    QVector<xcb_get_property_cookie_t> cookies;
+    cookies.reserve(childrenCount);
+    for (int i = 0; i < childrenCount; ++i) {
+        cookies << xcb_get_property(c, false, children[i], gXA_VROOT, XCB_ATOM_WINDOW, 0, 1);
+    }
+    for (int i = 0; i < childrenCount; ++i) {
+        if (gVRoot) {
+            xcb_discard_reply(c, cookies.at(i).sequence);
+            continue;
         }
-        if (children) {
-            XFree((char *)children);
+        // windows can vanish in the meantime, ignore the errors
+        xcb_generic_error_t *error = nullptr;
+        QScopedPointer<xcb_get_property_reply_t, QScopedPointerPodDeleter> property(xcb_get_property_reply(c, cookies.at(i), &error));
+        free(error);
+        if (!property.isNull() && property->type == XCB_ATOM_WINDOW && xcb_get_property_value_length(property.data()) >= int(sizeof(xcb_window_t))) {
+            gVRoot = children[i];
+            gVRootData = *static_cast<xcb_window_t *>(xcb_get_property_value(property.data()));
         }
     }
-
-    XSetErrorHandler(oldHandler);
 }
 
 //---------------------------------------------------------------------------
@@ -214,27 +330,26 @@ void X11Locker::setVRoot(Window win, Window vr)
         removeVRoot(gVRoot);
     }
 
-    unsigned long rw = QX11Info::appRootWindow();
-    unsigned long vroot_data[1] = {vr};
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_window_t rw = QX11Info::appRootWindow();
+    const xcb_window_t vroot_data[1] = {xcb_window_t(vr)};
 
-    Window rootReturn, parentReturn, *children;
-    unsigned int numChildren;
-    Window top = win;
-    while (1) {
-        if (!XQueryTree(QX11Info::display(), top, &rootReturn, &parentReturn, &children, &numChildren)) {
+    // one round trip per level, the background window is a direct child of the root window
+    xcb_window_t top = win;
+    while (true) {
+        QScopedPointer<xcb_query_tree_reply_t, QScopedPointerPodDeleter> tree(xcb_query_tree_reply(c, xcb_query_tree(c, top), nullptr));
+        if (tree.isNull()) {
             return;
         }
-        if (children) {
-            XFree((char *)children);
-        }
-        if (parentReturn == rw) {
+        if (tree->parent == rw) {
             break;
         } else {
-            top = parentReturn;
+            top = tree->parent;
         }
     }
 
-    XChangeProperty(QX11Info::display(), top, gXA_VROOT, XA_WINDOW, 32, PropModeReplace, (unsigned char *)vroot_data, 1);
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, top, gXA_VROOT, XCB_ATOM_WINDOW, 32, 1, vroot_data);
+    xcb_flush(c);
 }
 
 //---------------------------------------------------------------------------
@@ -299,9 +414,17 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
     }
     xcb_generic_event_t *event = reinterpret_cast<xcb_generic_event_t *>(message);
     const uint8_t responseType = event->response_type & ~0x80;
+    updateWindowStack(responseType, event);
+    if (globalAccel() && responseType == XCB_MAPPING_NOTIFY) {
+        // not filtered, Qt needs it as well
+        globalAccel()->keymapChanged(reinterpret_cast<xcb_mapping_notify_event_t *>(event));
+    }
+    if (!m_locked) {
+        return false;
+    }
     if (globalAccel() && responseType == XCB_KEY_PRESS) {
         if (globalAccel()->checkKeyPress(reinterpret_cast<xcb_key_press_event_t *>(event))) {
-            Q_EMIT userActivity();
+            notifyUserActivity();
             return true;
         }
     }
@@ -312,7 +435,16 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
     case XCB_KEY_PRESS:
     case XCB_KEY_RELEASE:
     case XCB_MOTION_NOTIFY:
-        Q_EMIT userActivity();
+        ++m_inputStatistics.received;
+        if (responseType == XCB_MOTION_NOTIFY) {
+            // reported together with the compressed motion events
+            m_motionActivityPending = true;
+            scheduleDeferredWork();
+        } else {
+            // keep the order of motion, button and key events
+            flushPendingMotions();
+            notifyUserActivity();
+        }
         if (!m_lockWindows.isEmpty()) {
             int x = 0;
             int y = 0;
@@ -323,33 +455,28 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
             } else if (responseType == XCB_MOTION_NOTIFY) {
                 coordFromEvent<xcb_motion_notify_event_t>(event, &x, &y);
             }
-            Window root_return;
-            int x_return, y_return;
-            unsigned int width_return, height_return, border_width_return, depth_return;
             for (WId window : qAsConst(m_lockWindows)) {
-                if (XGetGeometry(QX11Info::display(),
-                                 window,
-                                 &root_return,
-                                 &x_return,
-                                 &y_return,
-                                 &width_return,
-                                 &height_return,
-                                 &border_width_return,
-                                 &depth_return)
-                    && (x >= x_return && x <= x_return + (int)width_return) && (y >= y_return && y <= y_return + (int)height_return)) {
+                // the geometries are kept current from ConfigureNotify, so no round trip is needed per event
+                const auto geometry = m_lockWindowGeometries.constFind(window);
+                if (geometry == m_lockWindowGeometries.constEnd()) {
+                    continue;
+                }
+                if ((x >= geometry->x() && x <= geometry->x() + geometry->width()) && (y >= geometry->y() && y <= geometry->y() + geometry->height())) {
                     // We need to do our own focus handling (see comment in fakeFocusIn).
                     // For now: Focus on clicks inside the window
                     if (responseType == XCB_BUTTON_PRESS) {
                         fakeFocusIn(window);
                     }
-                    const int targetX = x - x_return;
-                    const int targetY = y - y_return;
+                    const int targetX = x - geometry->x();
+                    const int targetY = y - geometry->y();
                     if (responseType == XCB_KEY_PRESS || responseType == XCB_KEY_RELEASE) {
                         sendEvent<xcb_key_press_event_t>(event, window, targetX, targetY);
+                        ++m_inputStatistics.forwarded;
                     } else if (responseType == XCB_BUTTON_PRESS || responseType == XCB_BUTTON_RELEASE) {
                         sendEvent<xcb_button_press_event_t>(event, window, targetX, targetY);
+                        ++m_inputStatistics.forwarded;
                     } else if (responseType == XCB_MOTION_NOTIFY) {
-                        sendEvent<xcb_motion_notify_event_t>(event, window, targetX, targetY);
+                        queueMotion(reinterpret_cast<xcb_motion_notify_event_t *>(event), window, targetX, targetY);
                     }
                     break;
                 }
@@ -359,20 +486,10 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
         break;
     case XCB_CONFIGURE_NOTIFY: { // from SubstructureNotifyMask on the root window
         xcb_configure_notify_event_t *xc = reinterpret_cast<xcb_configure_notify_event_t *>(event);
-        if (xc->event == QX11Info::appRootWindow()) {
-            int index = findWindowInfo(xc->window);
-            if (index >= 0) {
-                int index2 = xc->above_sibling ? findWindowInfo(xc->above_sibling) : 0;
-                if (index2 < 0) {
-                    qCDebug(KSCREENLOCKER) << "Unknown above for ConfigureNotify";
-                } else { // move just above the other window
-                    if (index2 < index) {
-                        ++index2;
-                    }
-                    m_windowInfo.move(index, index2);
-                }
-            } else {
-                qCDebug(KSCREENLOCKER) << "Unknown toplevel for ConfigureNotify";
+        if (isLockParent(xc->event)) {
+            auto geometry = m_lockWindowGeometries.find(xc->window);
+            if (geometry != m_lockWindowGeometries.end()) {
+                *geometry = QRect(xc->x, xc->y, xc->width, xc->height);
             }
             // kDebug() << "ConfigureNotify:";
             // the stacking order changed, so let's change the stacking order again to what we want
@@ -383,14 +500,8 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
     }
     case XCB_MAP_NOTIFY: { // from SubstructureNotifyMask on the root window
         xcb_map_notify_event_t *xm = reinterpret_cast<xcb_map_notify_event_t *>(event);
-        if (xm->event == QX11Info::appRootWindow()) {
+        if (isLockParent(xm->event)) {
             qCDebug(KSCREENLOCKER) << "MapNotify:" << xm->window;
-            int index = findWindowInfo(xm->window);
-            if (index >= 0) {
-                m_windowInfo[index].viewable = true;
-            } else {
-                qCDebug(KSCREENLOCKER) << "Unknown toplevel for MapNotify";
-            }
             if (m_allowedWindows.contains(xm->window)) {
                 if (m_lockWindows.contains(xm->window)) {
                     qCDebug(KSCREENLOCKER) << "uhoh! duplicate!";
@@ -400,6 +511,7 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
                         m_background->show();
                     }
                     m_lockWindows.prepend(xm->window);
+                    updateLockWindowGeometry(xm->window);
                     fakeFocusIn(xm->window);
                 }
             }
@@ -415,15 +527,10 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
     }
     case XCB_UNMAP_NOTIFY: {
         xcb_unmap_notify_event_t *xu = reinterpret_cast<xcb_unmap_notify_event_t *>(event);
-        if (xu->event == QX11Info::appRootWindow()) {
+        if (isLockParent(xu->event)) {
             qCDebug(KSCREENLOCKER) << "UnmapNotify:" << xu->window;
-            int index = findWindowInfo(xu->window);
-            if (index >= 0) {
-                m_windowInfo[index].viewable = false;
-            } else {
-                qCDebug(KSCREENLOCKER) << "Unknown toplevel for MapNotify";
-            }
             m_lockWindows.removeAll(xu->window);
+            m_lockWindowGeometries.remove(xu->window);
             if (m_focusedLockWindow == xu->event && !m_lockWindows.empty()) {
                 // The currently focused window vanished, just focus the first one in the list
                 fakeFocusIn(m_lockWindows[0]);
@@ -436,15 +543,6 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
         xcb_create_notify_event_t *xc = reinterpret_cast<xcb_create_notify_event_t *>(event);
         if (xc->parent == QX11Info::appRootWindow()) {
             qCDebug(KSCREENLOCKER) << "CreateNotify:" << xc->window;
-            int index = findWindowInfo(xc->window);
-            if (index >= 0) {
-                qCDebug(KSCREENLOCKER) << "Already existing toplevel for CreateNotify";
-            } else {
-                WindowInfo info;
-                info.window = xc->window;
-                info.viewable = false;
-                m_windowInfo.append(info);
-            }
             ret = true;
         }
         break;
@@ -452,84 +550,185 @@ bool X11Locker::nativeEventFilter(const QByteArray &eventType, void *message, qi
     case XCB_DESTROY_NOTIFY: {
         xcb_destroy_notify_event_t *xd = reinterpret_cast<xcb_destroy_notify_event_t *>(event);
         if (xd->event == QX11Info::appRootWindow()) {
-            int index = findWindowInfo(xd->window);
-            if (index >= 0) {
-                m_windowInfo.removeAt(index);
+            ret = true;
+        }
+        break;
+    }
+    }
+    return ret;
+}
+
+void X11Locker::updateWindowStack(uint8_t responseType, xcb_generic_event_t *event)
+{
+    const xcb_window_t root = QX11Info::appRootWindow();
+    switch (responseType) {
+    case XCB_CONFIGURE_NOTIFY: {
+        xcb_configure_notify_event_t *xc = reinterpret_cast<xcb_configure_notify_event_t *>(event);
+        if (xc->event == root) {
+            if (m_windowStack.contains(xc->window)) {
+                // move just above the other window
+                if (!m_windowStack.restackAbove(xc->window, xc->above_sibling)) {
+                    qCDebug(KSCREENLOCKER) << "Unknown above for ConfigureNotify";
+                }
             } else {
-                qCDebug(KSCREENLOCKER) << "Unknown toplevel for DestroyNotify";
+                qCDebug(KSCREENLOCKER) << "Unknown toplevel for ConfigureNotify";
             }
-            ret = true;
+        }
+        break;
+    }
+    case XCB_MAP_NOTIFY: {
+        xcb_map_notify_event_t *xm = reinterpret_cast<xcb_map_notify_event_t *>(event);
+        if (xm->event == root && !m_windowStack.setViewable(xm->window, true)) {
+            qCDebug(KSCREENLOCKER) << "Unknown toplevel for MapNotify";
+        }
+        break;
+    }
+    case XCB_UNMAP_NOTIFY: {
+        xcb_unmap_notify_event_t *xu = reinterpret_cast<xcb_unmap_notify_event_t *>(event);
+        if (xu->event == root && !m_windowStack.setViewable(xu->window, false)) {
+            qCDebug(KSCREENLOCKER) << "Unknown toplevel for UnmapNotify";
+        }
+        break;
+    }
+    case XCB_CREATE_NOTIFY: {
+        xcb_create_notify_event_t *xc = reinterpret_cast<xcb_create_notify_event_t *>(event);
+        if (xc->parent == root) {
+            if (!m_windowStack.addOnTop(xc->window, false)) {
+                qCDebug(KSCREENLOCKER) << "Already existing toplevel for CreateNotify";
+            } else if (m_windowStack.size() > s_maxTrackedWindows) {
+                // we must have missed destroy notifies, start over instead of growing without bounds
+                qCWarning(KSCREENLOCKER) << "Tracking more than" << s_maxTrackedWindows << "toplevel windows, discovering them again";
+                discoverToplevels(xcb_query_tree(QX11Info::connection(), root));
+            }
+        }
+        break;
+    }
+    case XCB_DESTROY_NOTIFY: {
+        xcb_destroy_notify_event_t *xd = reinterpret_cast<xcb_destroy_notify_event_t *>(event);
+        if (xd->event == root && !m_windowStack.remove(xd->window)) {
+            qCDebug(KSCREENLOCKER) << "Unknown toplevel for DestroyNotify";
         }
         break;
     }
     case XCB_REPARENT_NOTIFY: {
         xcb_reparent_notify_event_t *xr = reinterpret_cast<xcb_reparent_notify_event_t *>(event);
-        if (xr->event == QX11Info::appRootWindow() && xr->parent != QX11Info::appRootWindow()) {
-            int index = findWindowInfo(xr->window);
-            if (index >= 0) {
-                m_windowInfo.removeAt(index);
-            } else {
+        if (xr->event == root && xr->parent != root) {
+            if (!m_windowStack.remove(xr->window)) {
                 qCDebug(KSCREENLOCKER) << "Unknown toplevel for ReparentNotify away";
             }
-        } else if (xr->parent == QX11Info::appRootWindow()) {
-            int index = findWindowInfo(xr->window);
-            if (index >= 0) {
+        } else if (xr->parent == root) {
+            if (!m_windowStack.addOnTop(xr->window, false)) {
                 qCDebug(KSCREENLOCKER) << "Already existing toplevel for ReparentNotify";
-            } else {
-                WindowInfo info;
-                info.window = xr->window;
-                info.viewable = false;
-                m_windowInfo.append(info);
             }
         }
         break;
     }
     case XCB_CIRCULATE_NOTIFY: {
         xcb_circulate_notify_event_t *xc = reinterpret_cast<xcb_circulate_notify_event_t *>(event);
-        if (xc->event == QX11Info::appRootWindow()) {
-            int index = findWindowInfo(xc->window);
-            if (index >= 0) {
-                m_windowInfo.move(index, xc->place == PlaceOnTop ? m_windowInfo.size() - 1 : 0);
-            } else {
+        if (xc->event == root) {
+            const bool known = xc->place == PlaceOnTop ? m_windowStack.moveToTop(xc->window) : m_windowStack.moveToBottom(xc->window);
+            if (!known) {
                 qCDebug(KSCREENLOCKER) << "Unknown toplevel for CirculateNotify";
             }
         }
         break;
     }
     }
-    return ret;
 }
 
-int X11Locker::findWindowInfo(Window w)
+void X11Locker::queueMotion(xcb_motion_notify_event_t *event, WId window, int x, int y)
 {
-    for (int i = 0; i < m_windowInfo.size(); ++i) {
-        if (m_windowInfo[i].window == w) {
-            return i;
+    for (PendingMotion &pending : m_pendingMotions) {
+        if (pending.window == window) {
+            // only the latest position matters to the greeter
+            pending.event = *event;
+            pending.x = x;
+            pending.y = y;
+            ++m_inputStatistics.dropped;
+            return;
         }
     }
-    return -1;
+    m_pendingMotions << PendingMotion{window, *event, x, y};
+}
+
+void X11Locker::flushPendingMotions()
+{
+    for (PendingMotion &pending : m_pendingMotions) {
+        sendEvent<xcb_motion_notify_event_t>(reinterpret_cast<xcb_generic_event_t *>(&pending.event), pending.window, pending.x, pending.y);
+        ++m_inputStatistics.forwarded;
+    }
+    m_pendingMotions.clear();
+    if (m_motionActivityPending) {
+        m_motionActivityPending = false;
+        notifyUserActivity();
+    }
+}
+
+X11Locker::InputStatistics X11Locker::inputStatistics() const
+{
+    return m_inputStatistics;
 }
 
 void X11Locker::stayOnTop()
 {
+    // inside of the composite overlay window nothing can get above the lock windows
+    if (!m_locked || m_overlayWindow != XCB_WINDOW_NONE) {
+        return;
+    }
+    // restack storms from the window manager end up in one restack once all events got processed
+    m_restackPending = true;
+    scheduleDeferredWork();
+}
+
+void X11Locker::scheduleDeferredWork()
+{
+    if (m_deferredWorkScheduled) {
+        return;
+    }
+    m_deferredWorkScheduled = true;
+    // posted events get processed after the batch of X events read in this event loop iteration
+    QMetaObject::invokeMethod(this, &X11Locker::processDeferredWork, Qt::QueuedConnection);
+}
+
+void X11Locker::processDeferredWork()
+{
+    m_deferredWorkScheduled = false;
+    flushPendingMotions();
+    restackIfNeeded();
+}
+
+void X11Locker::restackIfNeeded()
+{
+    if (!m_restackPending) {
+        return;
+    }
+    m_restackPending = false;
+
+    // the lock windows from top to bottom, finally the background
+    m_restackBuffer.clear();
+    for (WId w : qAsConst(m_lockWindows)) {
+        m_restackBuffer << w;
+    }
+    m_restackBuffer << m_background->winId();
+
+    // the stacking order tracked from the notify events already is what we want
+    if (m_windowStack.isOnTop(m_restackBuffer)) {
+        return;
+    }
+
     // this restacking is written in a way so that
     // if the stacking positions actually don't change,
     // all restacking operations will be no-op,
     // and no ConfigureNotify will be generated,
     // thus avoiding possible infinite loops
-    QVector<Window> stack(m_lockWindows.count() + 1);
-    int count = 0;
-    for (WId w : qAsConst(m_lockWindows)) {
-        stack[count++] = w;
+    xcb_connection_t *c = QX11Info::connection();
+    const uint32_t raise[] = {XCB_STACK_MODE_ABOVE};
+    xcb_configure_window(c, m_restackBuffer.first(), XCB_CONFIG_WINDOW_STACK_MODE, raise);
+    for (int i = 1; i < m_restackBuffer.count(); ++i) {
+        const uint32_t below[] = {m_restackBuffer.at(i - 1), XCB_STACK_MODE_BELOW};
+        xcb_configure_window(c, m_restackBuffer.at(i), XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE, below);
     }
-    // finally, the lock window
-    stack[count++] = m_background->winId();
-    // do the actual restacking if needed
-    XRaiseWindow(QX11Info::display(), stack[0]);
-    if (count > 1) {
-        XRestackWindows(QX11Info::display(), stack.data(), count);
-    }
-    XFlush(QX11Info::display());
+    xcb_flush(c);
 }
 
 void X11Locker::updateGeo()
@@ -546,9 +745,15 @@ void X11Locker::updateGeo()
 void X11Locker::addAllowedWindow(quint32 window)
 {
     m_allowedWindows << window;
+    if (m_overlayWindow != XCB_WINDOW_NONE) {
+        // a mapped window gets unmapped and mapped again by the X server, the MapNotify
+        // from inside of the overlay window makes it a lock window
+        xcb_reparent_window(QX11Info::connection(), window, m_overlayWindow, 0, 0);
+        xcb_flush(QX11Info::connection());
+        return;
+    }
     // test whether it's to show
-    const int index = findWindowInfo(window);
-    if (index == -1 || !m_windowInfo[index].viewable) {
+    if (!m_windowStack.isViewable(window)) {
         return;
     }
     if (m_lockWindows.contains(window)) {
@@ -566,8 +771,19 @@ void X11Locker::addAllowedWindow(quint32 window)
         }
 
         m_lockWindows.prepend(window);
+        updateLockWindowGeometry(window);
         stayOnTop();
     }
 }
 
+void X11Locker::updateLockWindowGeometry(WId window)
+{
+    xcb_connection_t *c = QX11Info::connection();
+    QScopedPointer<xcb_get_geometry_reply_t, QScopedPointerPodDeleter> geometry(xcb_get_geometry_reply(c, xcb_get_geometry(c, window), nullptr));
+    if (geometry.isNull()) {
+        return;
+    }
+    m_lockWindowGeometries.insert(window, QRect(geometry->x, geometry->y, geometry->width, geometry->height));
+}
+
 }
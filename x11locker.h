@@ -25,10 +25,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define SCREENLOCKER_LOCKWINDOW_H
 
 #include "abstractlocker.h"
+#include "x11windowstack.h"
 
 #include <QAbstractNativeEventFilter>
+#include <QHash>
+#include <QRect>
 #include <X11/Xlib.h>
 #include <fixx11h.h>
+#include <xcb/xcb.h>
 
 namespace ScreenLocker
 {
@@ -45,6 +49,25 @@ public:
     void hideLockWindow() override;
 
     void addAllowedWindow(quint32 window) override;
+    /**
+     * Puts the background and the greeter windows into the Composite overlay window from the
+     * next showLockWindow on, instead of keeping them above all other windows by restacking.
+     * Falls back to restacking if the Composite extension is not available.
+     **/
+    void setUseCompositeOverlay(bool use);
+
+    /**
+     * Counts the input events of the current lock. Motion events are compressed to the
+     * latest position per lock window once per event loop iteration, the replaced ones
+     * count as dropped.
+     **/
+    struct InputStatistics {
+        quint64 received = 0;
+        quint64 forwarded = 0;
+        quint64 dropped = 0;
+    };
+    InputStatistics inputStatistics() const;
+    bool showBackground() override;
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     bool nativeEventFilter(const QByteArray &eventType, void *message, long *result) override;
@@ -57,18 +80,69 @@ private Q_SLOTS:
 
 private:
     void initialize();
+    /**
+     * Starts tracking the stacking order over from the children in the reply to @p treeCookie.
+     **/
+    void discoverToplevels(xcb_query_tree_cookie_t treeCookie);
+    /**
+     * Keeps the stacking order current from the notify events on the root window. This
+     * happens also while not locked, so that locking does not need to discover the windows.
+     **/
+    void updateWindowStack(uint8_t responseType, xcb_generic_event_t *event);
+    void acquireCompositeOverlay();
+    void releaseCompositeOverlay();
+    /**
+     * Whether notifies about children of @p window concern the lock windows.
+     **/
+    bool isLockParent(xcb_window_t window) const;
     void saveVRoot();
     void setVRoot(Window win, Window vr);
     void removeVRoot(Window win);
-    int findWindowInfo(Window w);
+    void updateLockWindowGeometry(WId window);
     void fakeFocusIn(WId window);
     void stayOnTop() override;
-    struct WindowInfo {
-        Window window;
-        bool viewable;
+    /**
+     * Whether a compositing manager redirects the windows, in which case a mapped window
+     * is only on the outputs once the compositor painted it.
+     **/
+    bool isCompositingManagerRunning() const;
+    /**
+     * Makes sure processDeferredWork gets called once the X events of the current event
+     * loop iteration got processed.
+     **/
+    void scheduleDeferredWork();
+    void processDeferredWork();
+    /**
+     * Raises the lock windows and the background if stayOnTop got called since the last
+     * time and they are not on top already.
+     **/
+    void restackIfNeeded();
+    void queueMotion(xcb_motion_notify_event_t *event, WId window, int x, int y);
+    /**
+     * Forwards the compressed motion events to the lock windows.
+     **/
+    void flushPendingMotions();
+    X11WindowStack m_windowStack;
+    bool m_locked = false;
+    bool m_useCompositeOverlay = false;
+    xcb_window_t m_overlayWindow = XCB_WINDOW_NONE;
+    bool m_restackPending = false;
+    bool m_deferredWorkScheduled = false;
+    QVector<xcb_window_t> m_restackBuffer;
+    struct PendingMotion {
+        WId window;
+        xcb_motion_notify_event_t event;
+        int x;
+        int y;
     };
-    QList<WindowInfo> m_windowInfo;
+    QVector<PendingMotion> m_pendingMotions;
+    bool m_motionActivityPending = false;
+    InputStatistics m_inputStatistics;
     QList<WId> m_lockWindows;
+    /**
+     * Geometry of each of the m_lockWindows, used for forwarding input events.
+     **/
+    QHash<WId, QRect> m_lockWindowGeometries;
     QList<quint32> m_allowedWindows;
     WId m_focusedLockWindow;
 };
@@ -0,0 +1,140 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "x11windowstack.h"
+
+namespace ScreenLocker
+{
+bool X11WindowStack::addOnTop(xcb_window_t window, bool viewable)
+{
+    if (m_index.contains(window)) {
+        return false;
+    }
+    m_index.insert(window, m_stack.insert(m_stack.end(), Entry{window, viewable}));
+    return true;
+}
+
+bool X11WindowStack::remove(xcb_window_t window)
+{
+    const auto it = m_index.find(window);
+    if (it == m_index.end()) {
+        return false;
+    }
+    m_stack.erase(it.value());
+    m_index.erase(it);
+    return true;
+}
+
+bool X11WindowStack::contains(xcb_window_t window) const
+{
+    return m_index.contains(window);
+}
+
+bool X11WindowStack::isViewable(xcb_window_t window) const
+{
+    const auto it = m_index.constFind(window);
+    return it != m_index.constEnd() && it.value()->viewable;
+}
+
+bool X11WindowStack::setViewable(xcb_window_t window, bool viewable)
+{
+    const auto it = m_index.constFind(window);
+    if (it == m_index.constEnd()) {
+        return false;
+    }
+    it.value()->viewable = viewable;
+    return true;
+}
+
+bool X11WindowStack::restackAbove(xcb_window_t window, xcb_window_t sibling)
+{
+    if (sibling == XCB_WINDOW_NONE) {
+        return moveToBottom(window);
+    }
+    const auto it = m_index.constFind(window);
+    const auto siblingIt = m_index.constFind(sibling);
+    if (it == m_index.constEnd() || siblingIt == m_index.constEnd()) {
+        return false;
+    }
+    // splice keeps the node, so the iterators in the index stay valid
+    m_stack.splice(std::next(siblingIt.value()), m_stack, it.value());
+    return true;
+}
+
+bool X11WindowStack::moveToTop(xcb_window_t window)
+{
+    const auto it = m_index.constFind(window);
+    if (it == m_index.constEnd()) {
+        return false;
+    }
+    m_stack.splice(m_stack.end(), m_stack, it.value());
+    return true;
+}
+
+bool X11WindowStack::moveToBottom(xcb_window_t window)
+{
+    const auto it = m_index.constFind(window);
+    if (it == m_index.constEnd()) {
+        return false;
+    }
+    m_stack.splice(m_stack.begin(), m_stack, it.value());
+    return true;
+}
+
+bool X11WindowStack::isOnTop(const QVector<xcb_window_t> &windows) const
+{
+    auto wanted = windows.constBegin();
+    for (auto it = m_stack.crbegin(); it != m_stack.crend() && wanted != windows.constEnd(); ++it) {
+        if (it->window == *wanted) {
+            ++wanted;
+        } else if (it->viewable) {
+            return false;
+        }
+    }
+    return wanted == windows.constEnd();
+}
+
+int X11WindowStack::size() const
+{
+    return m_index.size();
+}
+
+qint64 X11WindowStack::memoryUsage() const
+{
+    // a list node holds the entry and two pointers, a hash node the key, the iterator and the next pointer
+    const qint64 listNode = sizeof(Entry) + 2 * sizeof(void *);
+    const qint64 hashNode = sizeof(xcb_window_t) + sizeof(std::list<Entry>::iterator) + 2 * sizeof(void *);
+    return m_index.size() * (listNode + hashNode) + m_index.capacity() * qint64(sizeof(void *));
+}
+
+QVector<xcb_window_t> X11WindowStack::windows() const
+{
+    QVector<xcb_window_t> result;
+    result.reserve(m_index.size());
+    for (const Entry &entry : m_stack) {
+        result << entry.window;
+    }
+    return result;
+}
+
+void X11WindowStack::clear()
+{
+    m_index.clear();
+    m_stack.clear();
+}
+
+}
@@ -0,0 +1,99 @@
+/********************************************************************
+ KSld - the KDE Screenlocker Daemon
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef SCREENLOCKER_X11WINDOWSTACK_H
+#define SCREENLOCKER_X11WINDOWSTACK_H
+
+#include <QHash>
+#include <QVector>
+
+#include <xcb/xproto.h>
+
+#include <list>
+
+namespace ScreenLocker
+{
+/**
+ * Mirrors the stacking order of the toplevel windows from the notify events on the root window.
+ *
+ * The windows are kept in a list ordered bottom to top together with a hash from the window
+ * to its list node, so that looking up, restacking and removing a window does not depend on
+ * the number of toplevels.
+ **/
+class X11WindowStack
+{
+public:
+    /**
+     * Adds @p window on top of the stack.
+     * @returns @c false if the window is already known
+     **/
+    bool addOnTop(xcb_window_t window, bool viewable);
+    /**
+     * @returns @c false if the window is not known
+     **/
+    bool remove(xcb_window_t window);
+
+    bool contains(xcb_window_t window) const;
+    bool isViewable(xcb_window_t window) const;
+    /**
+     * @returns @c false if the window is not known
+     **/
+    bool setViewable(xcb_window_t window, bool viewable);
+
+    /**
+     * Moves @p window directly above @p sibling, or to the bottom if @p sibling is XCB_WINDOW_NONE.
+     * @returns @c false if either window is not known
+     **/
+    bool restackAbove(xcb_window_t window, xcb_window_t sibling);
+    /**
+     * @returns @c false if the window is not known
+     **/
+    bool moveToTop(xcb_window_t window);
+    /**
+     * @returns @c false if the window is not known
+     **/
+    bool moveToBottom(xcb_window_t window);
+
+    /**
+     * Whether @p windows, ordered top to bottom, are the topmost viewable windows.
+     * Windows which are not viewable do not count as covering them.
+     **/
+    bool isOnTop(const QVector<xcb_window_t> &windows) const;
+
+    int size() const;
+    /**
+     * Approximate number of bytes allocated for tracking the windows.
+     **/
+    qint64 memoryUsage() const;
+    /**
+     * The windows ordered bottom to top.
+     **/
+    QVector<xcb_window_t> windows() const;
+    void clear();
+
+private:
+    struct Entry {
+        xcb_window_t window;
+        bool viewable;
+    };
+    std::list<Entry> m_stack;
+    QHash<xcb_window_t, std::list<Entry>::iterator> m_index;
+};
+
+}
+
+#endif